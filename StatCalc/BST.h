@@ -1,49 +1,263 @@
 #ifndef BST_H
 #define BST_H
 #include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include "RunningStats.h"
+#include "ModeIndex.h"
+#include "Percentile.h"
 
+// AVL node augmented with subtree size and sum so rank queries
+// don't need a full traversal.
 struct Node {
     double data;
     Node *left, *right;
-    Node(double val) : data(val), left(nullptr), right(nullptr) {}
+    int height;
+    size_t size;
+    double sum;
+    Node(double val) : data(val), left(nullptr), right(nullptr), height(1), size(1), sum(val) {}
+};
+
+// Bump allocator for tree nodes. Nodes are never freed one at a time;
+// reset() drops every slab at once, so clearing the tree is O(slabs).
+class NodeArena {
+private:
+    std::vector<Node*> slabs;
+    size_t used = 0;      // nodes handed out from the current slab
+    size_t capacity = 0;  // size of the current slab
+    static constexpr size_t firstSlab = 1024;
+    static constexpr size_t maxSlab = 1 << 20;
+
+    void release() {
+        for (Node* slab : slabs) ::operator delete(slab);
+        slabs.clear();
+        used = capacity = 0;
+    }
+
+public:
+    NodeArena() = default;
+    ~NodeArena() { release(); }
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    Node* create(double val) {
+        if (used == capacity) {
+            capacity = capacity ? std::min(capacity * 2, maxSlab) : firstSlab;
+            slabs.push_back(static_cast<Node*>(::operator new(capacity * sizeof(Node))));
+            used = 0;
+        }
+        return new (slabs.back() + used++) Node(val);
+    }
+
+    // Node is trivially destructible, so the slabs can be dropped as-is
+    void reset() { release(); }
 };
 
 class BST {
 private:
     Node* root;
-    void insert(Node*& node, double val) {
-        if (!node) node = new Node(val);
-        else if (val < node->data) insert(node->left, val);
-        else insert(node->right, val);
+    NodeArena arena;
+    RunningStats stats;
+    ModeIndex modeIndex;
+    // Bumped on every mutation; the sorted snapshot is rebuilt lazily when stale.
+    // Readers may race to rebuild it, so the rebuild is serialized separately.
+    unsigned long long version = 0;
+    std::atomic<unsigned long long> sortedVersion{0};
+    std::mutex sortedMutex;
+    std::vector<double> sorted;
+
+    static int height(Node* n) { return n ? n->height : 0; }
+    static size_t size(Node* n) { return n ? n->size : 0; }
+    static double sum(Node* n) { return n ? n->sum : 0.0; }
+
+    static void update(Node* n) {
+        n->height = 1 + std::max(height(n->left), height(n->right));
+        n->size = 1 + size(n->left) + size(n->right);
+        n->sum = n->data + sum(n->left) + sum(n->right);
     }
-    void inOrder(Node* node, std::vector<double>& v) {
-        if (!node) return;
-        inOrder(node->left, v);
-        v.push_back(node->data);
-        inOrder(node->right, v);
+
+    static Node* rotateRight(Node* n) {
+        Node* l = n->left;
+        n->left = l->right;
+        l->right = n;
+        update(n); update(l);
+        return l;
     }
-    void deleteTree(Node* node) {
-        if (!node) return;
-        deleteTree(node->left);
-        deleteTree(node->right);
-        delete node;
+
+    static Node* rotateLeft(Node* n) {
+        Node* r = n->right;
+        n->right = r->left;
+        r->left = n;
+        update(n); update(r);
+        return r;
     }
 
+    static Node* balance(Node* n) {
+        update(n);
+        int bf = height(n->left) - height(n->right);
+        if (bf > 1) {
+            if (height(n->left->left) < height(n->left->right)) n->left = rotateLeft(n->left);
+            return rotateRight(n);
+        }
+        if (bf < -1) {
+            if (height(n->right->right) < height(n->right->left)) n->right = rotateRight(n->right);
+            return rotateLeft(n);
+        }
+        return n;
+    }
+
+    // Recursion depth is bounded by the tree height, i.e. O(log n)
+    Node* insert(Node* node, double val) {
+        if (!node) return arena.create(val);
+        if (val < node->data) node->left = insert(node->left, val);
+        else node->right = insert(node->right, val);
+        return balance(node);
+    }
+    // Perfectly balanced subtree over v[lo, hi) of an already sorted range
+    Node* build(const std::vector<double>& v, size_t lo, size_t hi) {
+        if (lo >= hi) return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        Node* n = arena.create(v[mid]);
+        n->left = build(v, lo, mid);
+        n->right = build(v, mid + 1, hi);
+        update(n);
+        return n;
+    }
 public:
+    static constexpr bool exact = true;
+
+    // In-order iterator with an explicit stack, so callers can stream the
+    // values without materializing a vector. Invalidated by add()/clear().
+    class Iterator {
+    private:
+        std::vector<Node*> path;
+        void pushLeft(Node* n) {
+            for (; n; n = n->left) path.push_back(n);
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = double;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const double*;
+        using reference = const double&;
+
+        Iterator() = default;
+        explicit Iterator(Node* root) {
+            if (root) path.reserve(root->height);
+            pushLeft(root);
+        }
+        reference operator*() const { return path.back()->data; }
+        Iterator& operator++() {
+            Node* n = path.back();
+            path.pop_back();
+            pushLeft(n->right);
+            return *this;
+        }
+        Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+        bool operator==(const Iterator& o) const {
+            return path.empty() ? o.path.empty() : !o.path.empty() && path.back() == o.path.back();
+        }
+        bool operator!=(const Iterator& o) const { return !(*this == o); }
+    };
+
+    Iterator begin() const { return Iterator(root); }
+    Iterator end() const { return Iterator(); }
+
     BST() : root(nullptr) {}
-    ~BST() { deleteTree(root); }
-    
-    void add(double val) { insert(root, val); }
-    
-    void clear() { 
-        deleteTree(root);
-        root = nullptr; 
+    BST(const BST&) = delete;
+    BST& operator=(const BST&) = delete;
+
+    void add(double val) {
+        root = insert(root, val);
+        stats.add(val);
+        modeIndex.add(val);
+        version++;
+    }
+
+    // Inserts a whole batch with a single version bump. Large batches are
+    // merged with the existing values and the tree is rebuilt in O(n + m)
+    // instead of doing m separate O(log n) inserts.
+    void addBatch(std::vector<double> vals) {
+        if (vals.empty()) return;
+        for (double v : vals) { stats.add(v); modeIndex.add(v); }
+        if (vals.size() * 4 < count()) {
+            for (double v : vals) root = insert(root, v);
+            version++;
+            return;
+        }
+        std::sort(vals.begin(), vals.end());
+        std::vector<double> merged;
+        merged.reserve(count() + vals.size());
+        const std::vector<double>& old = getSorted();
+        std::merge(old.begin(), old.end(), vals.begin(), vals.end(), std::back_inserter(merged));
+        arena.reset();
+        root = build(merged, 0, merged.size());
+        version++;
+        sorted.swap(merged);
+        sortedVersion.store(version);
+    }
+
+    void clear() {
+        arena.reset();
+        root = nullptr;
+        stats.reset();
+        modeIndex.clear();
+        version++;
     }
 
-    std::vector<double> getSorted() {
-        std::vector<double> v;
-        inOrder(root, v);
-        return v;
+    const RunningStats& getStats() const { return stats; }
+    const ModeIndex& getModeIndex() const { return modeIndex; }
+    unsigned long long getVersion() const { return version; }
+
+    size_t count() const { return size(root); }
+    double total() const { return sum(root); }
+
+    // Number of stored values strictly less than val
+    size_t rank(double val) const {
+        size_t r = 0;
+        for (Node* n = root; n;) {
+            if (val <= n->data) n = n->left;
+            else { r += size(n->left) + 1; n = n->right; }
+        }
+        return r;
+    }
+
+    // k-th smallest value (0-based), k must be < count()
+    double select(size_t k) const {
+        Node* n = root;
+        while (n) {
+            size_t ls = size(n->left);
+            if (k < ls) n = n->left;
+            else if (k == ls) return n->data;
+            else { k -= ls + 1; n = n->right; }
+        }
+        return 0;
+    }
+
+    double percentile(double p) const {
+        return Percentile::interpolate(count(), p, [this](size_t k) { return select(k); });
+    }
+
+    double median() const { return percentile(50); }
+
+    // Reference stays valid until the next add()/clear(). Safe to call from
+    // several readers at once as long as no writer runs concurrently.
+    const std::vector<double>& getSorted() {
+        if (sortedVersion.load(std::memory_order_acquire) != version) {
+            std::lock_guard<std::mutex> lock(sortedMutex);
+            if (sortedVersion.load(std::memory_order_relaxed) != version) {
+                sorted.clear();
+                sorted.reserve(count());
+                for (double v : *this) sorted.push_back(v);
+                sortedVersion.store(version, std::memory_order_release);
+            }
+        }
+        return sorted;
     }
 };
-#endif
\ No newline at end of file
+#endif
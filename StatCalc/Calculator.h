@@ -1,64 +1,127 @@
 #ifndef CALCULATOR_H
 #define CALCULATOR_H
 #include <vector>
-#include <numeric>
 #include <cmath>
 #include <algorithm>
-#include <map>
+#include <cstdint>
+#include "Combinatorics.h"
+#include "Kernels.h"
+#include "Parallel.h"
+#include "Percentile.h"
+
+struct Summary {
+    size_t count = 0;
+    double mean = 0, variance = 0, sampleVariance = 0, stdDev = 0, sampleStdDev = 0;
+    double min = 0, max = 0, q1 = 0, median = 0, q3 = 0, iqr = 0;
+    double skewness = 0, kurtosis = 0; // population skewness, excess kurtosis
+};
 
 class Calculator {
 public:
-    static double getMean(const std::vector<double>& data) {
-        if (data.empty()) return 0;
-        return std::accumulate(data.begin(), data.end(), 0.0) / data.size();
+    // Sorts chunks on separate threads, then merges neighbouring runs
+    // pairwise, each level of merges also in parallel
+    static void parallelSort(std::vector<double>& data) {
+        unsigned chunks = Parallel::chunksFor(data.size());
+        std::vector<size_t> bounds(chunks + 1);
+        for (unsigned c = 0; c <= chunks; ++c) bounds[c] = data.size() * c / chunks;
+        Parallel::forChunks(chunks, data.size(), [&](unsigned, size_t b, size_t e) {
+            std::sort(data.begin() + b, data.begin() + e);
+        });
+        for (size_t width = 1; width < chunks; width *= 2) {
+            unsigned merges = (unsigned)((chunks + width - 1) / (2 * width));
+            Parallel::forChunks(merges, merges, [&](unsigned m, size_t, size_t) {
+                size_t c = m * 2 * width;
+                std::inplace_merge(data.begin() + bounds[c], data.begin() + bounds[c + width],
+                                   data.begin() + bounds[std::min<size_t>(c + 2 * width, chunks)]);
+            });
+        }
     }
 
-    static double getMedian(std::vector<double> data) {
-        if (data.empty()) return 0;
-        std::sort(data.begin(), data.end());
+    // Count, mean and central moment sums up to the fourth. of() reads a
+    // slice through the SIMD kernels: a compensated sum for the mean, then
+    // power sums shifted by it, corrected for the small residual offset.
+    // merge() is Pebay's pairwise combination, so chunks can be accumulated
+    // on separate threads and joined.
+    struct Moments {
+        double n = 0, mean = 0, m2 = 0, m3 = 0, m4 = 0;
+
+        static Moments of(const double* p, size_t len) {
+            Moments m;
+            if (len == 0) return m;
+            double shift = Kernels::sum(p, len) / len, s[4];
+            Kernels::powerSums(p, len, shift, s);
+            double k = (double)len, a = s[0] / k, a2 = a * a;
+            m.n = k;
+            m.mean = shift + a;
+            m.m2 = s[1] - k * a2;
+            m.m3 = s[2] - 3 * a * s[1] + 2 * k * a2 * a;
+            m.m4 = s[3] - 4 * a * s[2] + 6 * a2 * s[1] - 3 * k * a2 * a2;
+            return m;
+        }
+
+        void merge(const Moments& b) {
+            if (b.n == 0) return;
+            if (n == 0) { *this = b; return; }
+            double na = n, nb = b.n, k = na + nb;
+            double d = b.mean - mean, d2 = d * d;
+            double m4n = m4 + b.m4 + d2 * d2 * na * nb * (na * na - na * nb + nb * nb) / (k * k * k)
+                       + 6 * d2 * (na * na * b.m2 + nb * nb * m2) / (k * k) + 4 * d * (na * b.m3 - nb * m3) / k;
+            double m3n = m3 + b.m3 + d2 * d * na * nb * (na - nb) / (k * k) + 3 * d * (na * b.m2 - nb * m2) / k;
+            m2 += b.m2 + d2 * na * nb / k;
+            m3 = m3n;
+            m4 = m4n;
+            mean += d * nb / k;
+            n = k;
+        }
+    };
+
+    // All summary statistics except mode from one sorted snapshot: moments
+    // come from the SIMD kernels (split across threads for large inputs),
+    // order statistics are read by index. Unsorted input is copied and
+    // sorted first. Mode comes from the dataset's ModeIndex instead.
+    static Summary describe(const std::vector<double>& data) {
+        if (!std::is_sorted(data.begin(), data.end())) {
+            std::vector<double> sorted = data;
+            parallelSort(sorted);
+            return describe(sorted);
+        }
+        Summary out;
         size_t n = data.size();
-        return (n % 2 == 0) ? (data[n/2 - 1] + data[n/2]) / 2.0 : data[n/2];
-    }
+        if (n == 0) return out;
 
-    static std::vector<double> getMode(const std::vector<double>& data) {
-        if (data.empty()) return {};
-        std::map<double, int> freq;
-        for (double val : data) freq[val]++;
-        int max_f = 0;
-        for (auto const& [val, count] : freq) if (count > max_f) max_f = count;
-        std::vector<double> modes;
-        for (auto const& [val, count] : freq) if (count == max_f) modes.push_back(val);
-        return modes;
-    }
+        unsigned chunks = Parallel::chunksFor(n);
+        std::vector<Moments> moments(chunks);
+        Parallel::forChunks(chunks, n, [&](unsigned c, size_t b, size_t e) {
+            moments[c] = Moments::of(data.data() + b, e - b);
+        });
 
-    static double getStandardDeviation(const std::vector<double>& data) {
-        if (data.size() < 2) return 0;
-        double mean = getMean(data);
-        double sum = 0;
-        for(double x : data) sum += (x - mean) * (x - mean);
-        return std::sqrt(sum / data.size());
+        Moments m;
+        for (const Moments& part : moments) m.merge(part);
+        out.count = n;
+        out.mean = m.mean;
+        out.variance = m.m2 / n;
+        out.sampleVariance = n > 1 ? m.m2 / (n - 1) : 0;
+        out.stdDev = std::sqrt(out.variance);
+        out.sampleStdDev = std::sqrt(out.sampleVariance);
+        out.min = data.front();
+        out.max = data.back();
+        out.q1 = Percentile::sorted(data, 25);
+        out.median = Percentile::sorted(data, 50);
+        out.q3 = Percentile::sorted(data, 75);
+        out.iqr = out.q3 - out.q1;
+        if (m.m2 > 0) {
+            out.skewness = std::sqrt((double)n) * m.m3 / std::pow(m.m2, 1.5);
+            out.kurtosis = n * m.m4 / (m.m2 * m.m2) - 3;
+        }
+        return out;
     }
 
-    static long long nCr(int n, int r) {
-        if (r < 0 || r > n) return 0;
-        if (r == 0 || r == n) return 1;
-        if (r > n / 2) r = n - r;
-        long long res = 1;
-        for (int i = 1; i <= r; ++i) res = res * (n - i + 1) / i;
-        return res;
-    }
+    // Overflow-free; see Combinatorics for exact and log-space variants
+    static double nCr(int64_t n, int64_t r) { return Combinatorics::choose(n, r); }
 
-    static long long nPr(int n, int r) {
-        if (r < 0 || r > n) return 0;
-        long long res = 1;
-        for (int i = 0; i < r; ++i) res *= (n - i);
-        return res;
-    }
+    static double nPr(int64_t n, int64_t r) { return Combinatorics::permute(n, r); }
 
-    static double binomialProb(int n, int k, double p) {
-        if (p < 0.0 || p > 1.0 || k < 0 || k > n) return 0; 
-        return (double)nCr(n, k) * std::pow(p, k) * std::pow(1.0 - p, n - k);
-    }
+    static double binomialProb(int64_t n, int64_t k, double p) { return Combinatorics::binomialPmf(n, k, p); }
 
     // --- Independent Event Helper ---
     // Figures out base P(A) and P(B) from whatever 2 values were given
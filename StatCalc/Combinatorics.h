@@ -0,0 +1,177 @@
+#ifndef COMBINATORICS_H
+#define COMBINATORICS_H
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// nCr / nPr without overflow. Results that fit 64 bits are computed
+// exactly with overflow-checked multiplication and rounded once, so they
+// match the integers. Larger ones come from logs: log(n!/m!) is summed
+// directly for short ranges and otherwise taken from a Stirling series
+// written in difference form, which avoids the cancellation of subtracting
+// two huge log-factorials. Exact decimal strings of any size up to
+// maxExactDigits use a small base-1e9 big integer.
+class Combinatorics {
+private:
+    static const int64_t tableSize = 1 << 20;
+
+    static const std::vector<double>& logFactorials() {
+        static const std::vector<double> table = [] {
+            std::vector<double> t(tableSize + 1);
+            for (int64_t i = 0; i <= tableSize; ++i) t[i] = std::lgamma((double)i + 1);
+            return t;
+        }();
+        return table;
+    }
+
+    // Base-1e9 little-endian limbs; only the operations the exact loops need
+    struct BigUInt {
+        std::vector<uint32_t> limbs{1};
+        void mul(uint32_t m) {
+            uint64_t carry = 0;
+            for (uint32_t& l : limbs) {
+                uint64_t cur = (uint64_t)l * m + carry;
+                l = (uint32_t)(cur % 1000000000);
+                carry = cur / 1000000000;
+            }
+            while (carry) { limbs.push_back((uint32_t)(carry % 1000000000)); carry /= 1000000000; }
+        }
+        void div(uint32_t d) { // exact division, remainder is known to be zero
+            uint64_t rem = 0;
+            for (size_t i = limbs.size(); i-- > 0;) {
+                uint64_t cur = limbs[i] + rem * 1000000000;
+                limbs[i] = (uint32_t)(cur / d);
+                rem = cur % d;
+            }
+            while (limbs.size() > 1 && limbs.back() == 0) limbs.pop_back();
+        }
+        std::string str() const {
+            std::string s = std::to_string(limbs.back());
+            for (size_t i = limbs.size() - 1; i-- > 0;) {
+                std::string part = std::to_string(limbs[i]);
+                s += std::string(9 - part.size(), '0') + part;
+            }
+            return s;
+        }
+    };
+
+    static bool mulChecked(uint64_t a, uint64_t b, uint64_t& out) {
+        if (a != 0 && b > UINT64_MAX / a) return false;
+        out = a * b;
+        return true;
+    }
+
+    static uint64_t gcd(uint64_t a, uint64_t b) {
+        while (b) { uint64_t t = a % b; a = b; b = t; }
+        return a;
+    }
+
+    // Exact nCr / nPr when they fit 64 bits. The partial products only grow,
+    // so the loops stop at the first overflow, within ~70 steps.
+    static bool chooseFits(int64_t n, int64_t r, uint64_t& out) {
+        r = std::min(r, n - r);
+        uint64_t res = 1;
+        for (int64_t i = 1; i <= r; ++i) {
+            // res * (n-r+i) is divisible by i; split i over gcd(res, i) first
+            uint64_t g = gcd(res, (uint64_t)i);
+            if (!mulChecked(res / g, (uint64_t)(n - r + i) / ((uint64_t)i / g), res)) return false;
+        }
+        out = res;
+        return true;
+    }
+    static bool permuteFits(int64_t n, int64_t r, uint64_t& out) {
+        uint64_t res = 1;
+        for (int64_t i = 0; i < r; ++i)
+            if (!mulChecked(res, (uint64_t)(n - i), res)) return false;
+        out = res;
+        return true;
+    }
+
+    // Stirling series for lgamma(x) without the leading terms, x >= 17
+    static double stirlingTail(double x) {
+        double x2 = x * x;
+        return (1.0 / 12 - (1.0 / 360 - 1.0 / (1260 * x2)) / x2) / x;
+    }
+
+    // log(n! / m!) for n >= m
+    static double logFactorialRatio(int64_t n, int64_t m) {
+        int64_t d = n - m;
+        if (d <= 32) {
+            double s = 0;
+            for (int64_t i = m + 1; i <= n; ++i) s += std::log((double)i);
+            return s;
+        }
+        if (m < 16) return logFactorial(n) - logFactorial(m);
+        // lgamma(a) - lgamma(b) with a = n+1, b = m+1:
+        // (a-1/2)log1p(d/b) + d(log b - 1) + tail(a) - tail(b)
+        double a = (double)n + 1, b = (double)m + 1;
+        return (a - 0.5) * std::log1p((double)d / b) + d * (std::log(b) - 1) + stirlingTail(a) - stirlingTail(b);
+    }
+
+public:
+    static const int64_t maxExactDigits = 10000;
+
+    static double logFactorial(int64_t n) {
+        if (n <= tableSize) return logFactorials()[n];
+        return std::lgamma((double)n + 1);
+    }
+
+    // Natural log of nCr / nPr; -inf when the count is zero
+    static double logChoose(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return -std::numeric_limits<double>::infinity();
+        r = std::min(r, n - r);
+        return logFactorialRatio(n, n - r) - logFactorial(r);
+    }
+    static double logPermute(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return -std::numeric_limits<double>::infinity();
+        return logFactorialRatio(n, n - r);
+    }
+
+    // Overflows to +inf only past DBL_MAX
+    static double choose(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return 0;
+        uint64_t exact;
+        if (chooseFits(n, r, exact)) return (double)exact;
+        return std::exp(logChoose(n, r));
+    }
+    static double permute(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return 0;
+        uint64_t exact;
+        if (permuteFits(n, r, exact)) return (double)exact;
+        return std::exp(logPermute(n, r));
+    }
+
+    static int64_t digits(double logValue) { return (int64_t)std::floor(logValue / std::log(10.0)) + 1; }
+
+    // Exact decimal value; empty if it would exceed maxExactDigits or n
+    // doesn't fit a limb multiplier
+    static std::string chooseExact(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return "0";
+        if (n > UINT32_MAX || digits(logChoose(n, r)) > maxExactDigits) return "";
+        r = std::min(r, n - r);
+        BigUInt res;
+        for (int64_t i = 1; i <= r; ++i) { res.mul((uint32_t)(n - r + i)); res.div((uint32_t)i); }
+        return res.str();
+    }
+    static std::string permuteExact(int64_t n, int64_t r) {
+        if (r < 0 || r > n) return "0";
+        if (n > UINT32_MAX || digits(logPermute(n, r)) > maxExactDigits) return "";
+        BigUInt res;
+        for (int64_t i = 0; i < r; ++i) res.mul((uint32_t)(n - i));
+        return res.str();
+    }
+
+    // P(X = k) for X ~ Binomial(n, p); in log space once nCr leaves 64 bits
+    static double binomialPmf(int64_t n, int64_t k, double p) {
+        if (p < 0.0 || p > 1.0 || k < 0 || k > n) return 0;
+        if (p == 0.0) return k == 0 ? 1 : 0;
+        if (p == 1.0) return k == n ? 1 : 0;
+        uint64_t exact;
+        if (chooseFits(n, k, exact)) return (double)exact * std::pow(p, (double)k) * std::pow(1.0 - p, (double)(n - k));
+        return std::exp(logChoose(n, k) + k * std::log(p) + (n - k) * std::log1p(-p));
+    }
+};
+#endif
@@ -0,0 +1,188 @@
+#ifndef DATASET_STORE_H
+#define DATASET_STORE_H
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include "json.hpp"
+#include "DurableFile.h"
+
+using json = nlohmann::json;
+
+// Persists the dataset as a JSON snapshot plus an append-only log of
+// mutations, so each insert costs one short line instead of a full rewrite.
+//
+// Log format, one record per line:
+//   g <generation>   header, must match the snapshot's generation
+//   a <value>        value added
+//
+// Compaction writes a new snapshot with generation + 1 before starting a
+// fresh log, so a crash in between leaves a stale log that replay ignores.
+//
+// Only finite values are stored; written with max_digits10 they round-trip
+// exactly. Non-finite values left by older builds (inf/nan in the log, null
+// in the snapshot) are dropped on load with a warning, a torn last log line
+// is dropped likewise, and any other malformed record stops the load.
+//
+// Write failures are reported rather than swallowed: a snapshot that can't
+// be written in full leaves the previous snapshot and log in place, and once
+// an append fails nothing more is logged until a compaction succeeds, since
+// records after a torn one would be unreadable.
+class DatasetStore {
+private:
+    std::string snapshotFile;
+    std::string logFile;
+    std::ofstream log;
+    unsigned long long generation = 0;
+    size_t logEntries = 0;
+    size_t snapshotSize = 0;
+    bool droppedOnLoad = false; // forces a rewrite so dropped records are gone
+    bool logFailed = false;
+    static const size_t minCompact = 4096;
+
+    void openLog() {
+        log.close();
+        log.open(logFile, std::ios::out | std::ios::trunc);
+        log.precision(std::numeric_limits<double>::max_digits10);
+        log << "g " << generation << "\n";
+        log.flush();
+        logEntries = 0;
+        logFailed = !log;
+    }
+
+    // Keeps appending to a log whose header matched on load
+    void reopenLog() {
+        log.close();
+        log.open(logFile, std::ios::out | std::ios::app);
+        log.precision(std::numeric_limits<double>::max_digits10);
+        logFailed = !log;
+    }
+
+    void replay(std::vector<double>& data) {
+        std::ifstream in(logFile);
+        std::string line;
+        if (!std::getline(in, line)) return;
+        std::istringstream header(line);
+        char tag; unsigned long long gen;
+        if (!(header >> tag >> gen) || tag != 'g' || gen != generation) return;
+        size_t lineNo = 1, nonFinite = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            if (in.eof()) { // last line without its newline: an interrupted write
+                std::cerr << logFile << ": dropping torn last record\n";
+                droppedOnLoad = true;
+                break;
+            }
+            std::istringstream rec(line);
+            std::string token;
+            char* end = nullptr;
+            double v = 0;
+            bool ok = (rec >> tag >> token) && tag == 'a';
+            if (ok) { v = std::strtod(token.c_str(), &end); ok = *end == '\0'; }
+            if (!ok) throw std::runtime_error(logFile + ": malformed record at line " + std::to_string(lineNo));
+            if (!std::isfinite(v)) { nonFinite++; continue; }
+            data.push_back(v);
+            logEntries++;
+        }
+        if (nonFinite) {
+            std::cerr << logFile << ": dropped " << nonFinite << " non-finite values\n";
+            droppedOnLoad = true;
+        }
+    }
+
+    // Snapshot values; nulls are what older builds wrote for inf/nan
+    std::vector<double> readValues(const json& j) {
+        std::vector<double> data;
+        data.reserve(j.size());
+        size_t dropped = 0;
+        for (const auto& v : j) {
+            if (v.is_number()) data.push_back(v.get<double>());
+            else dropped++;
+        }
+        if (dropped) {
+            std::cerr << snapshotFile << ": dropped " << dropped << " non-numeric values\n";
+            droppedOnLoad = true;
+        }
+        return data;
+    }
+
+public:
+    DatasetStore(std::string snapshot = "dataset.json", std::string logName = "dataset.log")
+        : snapshotFile(std::move(snapshot)), logFile(std::move(logName)) {}
+
+    // Reads the snapshot, replays the log on top of it and reopens the log
+    // for appending. Older snapshots stored as a bare array are accepted.
+    std::vector<double> load() {
+        std::vector<double> data;
+        std::ifstream file(snapshotFile);
+        if (file.is_open() && file.peek() != std::ifstream::traits_type::eof()) {
+            json j; file >> j;
+            if (j.is_array()) data = readValues(j);
+            else {
+                generation = j.value("generation", 0ULL);
+                data = readValues(j["values"]);
+            }
+        }
+        file.close();
+        snapshotSize = data.size();
+        replay(data);
+        if (logEntries == 0 && !droppedOnLoad) openLog();
+        else if (!compact(data)) {
+            // The dropped records are still in the log, so it can't be extended
+            if (droppedOnLoad) throw std::runtime_error(snapshotFile + ": could not rewrite snapshot");
+            reopenLog();
+        }
+        return data;
+    }
+
+    // Callers reject non-finite values before they reach the dataset. False
+    // if the value may not have reached the log; the caller should then not
+    // apply it, and compact() to start a fresh log.
+    bool append(double v) {
+        if (!std::isfinite(v)) throw std::invalid_argument("non-finite value");
+        if (logFailed) return false;
+        log << "a " << v << "\n";
+        log.flush();
+        if (!log) { logFailed = true; return false; }
+        logEntries++;
+        return true;
+    }
+
+    // One flush for the whole batch
+    bool append(const std::vector<double>& vals) {
+        for (double v : vals)
+            if (!std::isfinite(v)) throw std::invalid_argument("non-finite value");
+        if (logFailed) return false;
+        for (double v : vals) log << "a " << v << "\n";
+        log.flush();
+        if (!log) { logFailed = true; return false; }
+        logEntries += vals.size();
+        return true;
+    }
+
+    // Compacting once the log outgrows the snapshot keeps ingest amortized O(1)
+    bool shouldCompact() const {
+        return logEntries >= minCompact && logEntries >= snapshotSize;
+    }
+
+    // False if the snapshot couldn't be written; the old snapshot and log
+    // are kept and still describe the data as of the last successful append
+    bool compact(const std::vector<double>& data) {
+        if (!DurableFile::replace(snapshotFile, json({{"generation", generation + 1}, {"values", data}}).dump())) {
+            std::cerr << snapshotFile << ": snapshot write failed, keeping the previous one\n";
+            return false;
+        }
+        generation++;
+        snapshotSize = data.size();
+        openLog();
+        return true;
+    }
+};
+
+#endif
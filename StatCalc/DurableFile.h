@@ -0,0 +1,39 @@
+#ifndef DURABLE_FILE_H
+#define DURABLE_FILE_H
+#include <string>
+#include <cstdio>
+#include <system_error>
+#include <filesystem>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Replaces a file so that a crash or a failed write leaves either the old or
+// the new contents, never a truncated mix: the text goes to path + ".tmp",
+// is synced to disk, and only then renamed over `path`.
+struct DurableFile {
+    // False if any step failed; the original file is untouched in that case
+    static bool replace(const std::string& path, const std::string& text) {
+        std::string tmp = path + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(text.data(), 1, text.size(), f) == text.size();
+        ok = std::fflush(f) == 0 && ok;
+#ifdef _WIN32
+        ok = ok && _commit(_fileno(f)) == 0;
+#else
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+        ok = std::fclose(f) == 0 && ok;
+        std::error_code ec;
+        if (ok) std::filesystem::rename(tmp, path, ec);
+        if (!ok || ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,114 @@
+#ifndef FLAT_DATASET_H
+#define FLAT_DATASET_H
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include "RunningStats.h"
+#include "ModeIndex.h"
+#include "Percentile.h"
+
+// Drop-in alternative to BST for read-mostly workloads: one contiguous
+// sorted vector plus a small unsorted insertion buffer that is sorted and
+// merged in the first time a read needs it. Reads never chase pointers.
+// Concurrent readers are safe without a writer; the lazy merge is guarded.
+class FlatDataset {
+private:
+    mutable std::vector<double> data;
+    mutable std::vector<double> pending;
+    mutable std::atomic<bool> dirty{false};
+    mutable std::mutex flushMutex;
+    RunningStats stats;
+    ModeIndex modeIndex;
+    double sum = 0;
+    unsigned long long version = 0;
+    static constexpr size_t minBuffer = 4096;
+
+    // Buffer grows with sqrt(n) so a merge every limit inserts stays
+    // amortized O(sqrt n) per insert
+    size_t bufferLimit() const {
+        return std::max(minBuffer, (size_t)std::sqrt((double)data.size()));
+    }
+
+    void flush() const {
+        if (!dirty.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(flushMutex);
+        if (!dirty.load(std::memory_order_relaxed)) return;
+        std::sort(pending.begin(), pending.end());
+        size_t mid = data.size();
+        data.insert(data.end(), pending.begin(), pending.end());
+        std::inplace_merge(data.begin(), data.begin() + mid, data.end());
+        pending.clear();
+        dirty.store(false, std::memory_order_release);
+    }
+
+public:
+    static constexpr bool exact = true;
+
+    void add(double val) {
+        pending.push_back(val);
+        dirty.store(true);
+        stats.add(val);
+        modeIndex.add(val);
+        sum += val;
+        version++;
+        if (pending.size() >= bufferLimit()) flush();
+    }
+
+    void addBatch(std::vector<double> vals) {
+        if (vals.empty()) return;
+        for (double v : vals) { stats.add(v); modeIndex.add(v); sum += v; }
+        pending.insert(pending.end(), vals.begin(), vals.end());
+        dirty.store(true);
+        version++;
+        flush();
+    }
+
+    void clear() {
+        data.clear();
+        pending.clear();
+        dirty.store(false);
+        stats.reset();
+        modeIndex.clear();
+        sum = 0;
+        version++;
+    }
+
+    const RunningStats& getStats() const { return stats; }
+    const ModeIndex& getModeIndex() const { return modeIndex; }
+    unsigned long long getVersion() const { return version; }
+
+    size_t count() const { return stats.n; }
+    double total() const { return sum; }
+
+    // Number of stored values strictly less than val
+    size_t rank(double val) const {
+        flush();
+        return std::lower_bound(data.begin(), data.end(), val) - data.begin();
+    }
+
+    // k-th smallest value (0-based), k must be < count()
+    double select(size_t k) const {
+        flush();
+        return k < data.size() ? data[k] : 0;
+    }
+
+    double percentile(double p) const {
+        flush();
+        return Percentile::sorted(data, p);
+    }
+
+    double median() const { return percentile(50); }
+
+    std::vector<double>::const_iterator begin() const { flush(); return data.begin(); }
+    std::vector<double>::const_iterator end() const { flush(); return data.end(); }
+
+    // Reference stays valid until the next add()/clear()
+    const std::vector<double>& getSorted() {
+        flush();
+        return data;
+    }
+};
+#endif
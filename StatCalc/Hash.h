@@ -0,0 +1,27 @@
+#ifndef HASH_H
+#define HASH_H
+#include <cstdint>
+#include <cstring>
+
+// splitmix64 finalizer over the bit pattern of a value. -0.0 and 0.0 count
+// as the same value everywhere: of() hashes them alike, and tables that keep
+// the value itself store normalize(val) so a mode or heavy hitter is never
+// reported as -0.
+struct ValueHash {
+    static double normalize(double val) { return val == 0 ? 0.0 : val; }
+
+    static uint64_t of(double val) {
+        val = normalize(val);
+        uint64_t x;
+        std::memcpy(&x, &val, sizeof(x));
+        return mix(x);
+    }
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+};
+#endif
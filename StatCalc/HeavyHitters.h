@@ -0,0 +1,99 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include "Hash.h"
+
+// Space-Saving top-k counter (Metwally et al.). Tracks at most `capacity`
+// values; an untracked value evicts the current minimum and inherits its
+// count as overestimation error. Any value occurring more than n / capacity
+// times is guaranteed to be tracked. Counters sit in a min-heap so every
+// update is O(log capacity).
+class HeavyHitters {
+public:
+    struct Entry {
+        double value;
+        uint64_t count; // upper bound on the true count
+        uint64_t error; // count - error is a lower bound
+    };
+
+private:
+    size_t capacity;
+    std::vector<Entry> heap;
+    std::unordered_map<double, size_t> slot; // value -> heap index
+    uint64_t n = 0;
+
+    void swapAt(size_t a, size_t b) {
+        std::swap(heap[a], heap[b]);
+        slot[heap[a].value] = a;
+        slot[heap[b].value] = b;
+    }
+
+    // Counts only grow, so entries only ever move down
+    void siftDown(size_t i) {
+        for (;;) {
+            size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < heap.size() && heap[l].count < heap[m].count) m = l;
+            if (r < heap.size() && heap[r].count < heap[m].count) m = r;
+            if (m == i) return;
+            swapAt(i, m);
+            i = m;
+        }
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0 && heap[(i - 1) / 2].count > heap[i].count) {
+            swapAt(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+public:
+    explicit HeavyHitters(size_t capacity = 256) : capacity(std::max<size_t>(capacity, 1)) {
+        heap.reserve(this->capacity);
+        slot.reserve(this->capacity);
+    }
+
+    void add(double val) {
+        val = ValueHash::normalize(val);
+        n++;
+        auto it = slot.find(val);
+        if (it != slot.end()) {
+            heap[it->second].count++;
+            siftDown(it->second);
+        } else if (heap.size() < capacity) {
+            heap.push_back({val, 1, 0});
+            slot[val] = heap.size() - 1;
+            siftUp(heap.size() - 1);
+        } else {
+            Entry& min = heap[0];
+            slot.erase(min.value);
+            min = {val, min.count + 1, min.count};
+            slot[val] = 0;
+            siftDown(0);
+        }
+    }
+
+    void clear() {
+        heap.clear();
+        slot.clear();
+        n = 0;
+    }
+
+    // Tracked values, highest count first
+    std::vector<Entry> top() const {
+        std::vector<Entry> out = heap;
+        std::sort(out.begin(), out.end(), [](const Entry& a, const Entry& b) {
+            return a.count != b.count ? a.count > b.count : a.value < b.value;
+        });
+        return out;
+    }
+
+    // Worst-case overcount of any reported entry
+    uint64_t maxError() const { return heap.size() < capacity ? 0 : n / capacity; }
+    size_t getCapacity() const { return capacity; }
+};
+#endif
@@ -1,79 +1,329 @@
 #ifndef HISTORY_MANAGER_H
 #define HISTORY_MANAGER_H
 
-#include <stack>
-#include <deque>
+#include <vector>
 #include <string>
+#include <cstdint>
+#include <algorithm>
 #include <fstream>
+#include <mutex>
+#include <cmath>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
 #include "json.hpp"
+#include "DurableFile.h"
 
 using json = nlohmann::json;
 
+// Recorded operations, stored as a one-byte id instead of a string
+enum class Operation : uint8_t {
+    None, Mean, Median, Percentile, Mode, StdDev, Summary, Distinct,
+    NCr, NPr, Binomial, NotA, NotB, AAndB, AOrB, AXorB, Neither, Count
+};
+
+// Display names, which are also what history.json stores
+inline const char* operationName(Operation op) {
+    static const char* const names[] = {
+        "", "Mean", "Median", "Percentile", "Mode", "Std Dev", "Summary", "Distinct",
+        "nCr", "nPr", "Binomial", "P(A')", "P(B')", "P(AnB)", "P(AuB)", "P(AxB)", "P((AuB)')"
+    };
+    return names[(size_t)op];
+}
+
+inline Operation operationFromName(const std::string& name) {
+    for (uint8_t i = 0; i < (uint8_t)Operation::Count; ++i)
+        if (name == operationName((Operation)i)) return (Operation)i;
+    return Operation::None;
+}
+
+// seq is unique and increasing: undo and redo also take a number, so an
+// entry's seq says when it (re)appeared in the history
 struct CalcResult {
-    std::string operation;
+    Operation operation;
     double result;
+    uint64_t seq;
 };
 
+// Fixed-capacity FIFO over a preallocated buffer; pushing when full
+// overwrites the oldest entry
+class HistoryRing {
+private:
+    std::vector<CalcResult> buf;
+    size_t head = 0; // index of the oldest entry
+    size_t count = 0;
+
+public:
+    explicit HistoryRing(size_t capacity) : buf(capacity > 0 ? capacity : 1) {}
+
+    void push_back(const CalcResult& r) {
+        if (count == buf.size()) { buf[head] = r; head = (head + 1) % buf.size(); }
+        else buf[(head + count++) % buf.size()] = r;
+    }
+    void pop_back() { count--; }
+    const CalcResult& back() const { return buf[(head + count - 1) % buf.size()]; }
+    const CalcResult& operator[](size_t i) const { return buf[(head + i) % buf.size()]; }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    size_t capacity() const { return buf.size(); }
+    void clear() { head = count = 0; }
+
+    // Entries oldest first, as at most two contiguous copies
+    void copyTo(std::vector<CalcResult>& out) const {
+        size_t first = std::min(count, buf.size() - head);
+        out.assign(buf.begin() + head, buf.begin() + head + first);
+        out.insert(out.end(), buf.begin(), buf.begin() + (count - first));
+    }
+};
+
+// Keeps the last `capacity` results in a ring allocated once at startup, so
+// recording never allocates. Persistence runs on a background writer:
+// changes only mark the history dirty, and the writer waits `coalesce` after
+// the first change so a burst of requests becomes a single write. The
+// destructor flushes what's left.
 class HistoryManager {
 private:
-    std::deque<CalcResult> history;
-    std::stack<CalcResult> redoStack; // Second stack for Redo
+    HistoryRing history;
+    // Undone entries. history.size() + redoStack.size() never exceeds the
+    // capacity, so reserving it up front means pushes never reallocate.
+    std::vector<CalcResult> redoStack;
+    uint64_t seq = 0; // last sequence number handed out
+
+    // An undo at seq `at` removes the entry numbered `from`. Later entries
+    // are numbered past `at`, so a cursor in [from, at) can only have come
+    // from before the undo and may include the removed entry. Nested ranges
+    // are merged, leaving them disjoint and sorted; at most `capacity` are
+    // kept and cursors below `forgetBelow` are treated as stale.
+    struct Removal { uint64_t from, at; };
+    std::vector<Removal> removals;
+    uint64_t forgetBelow = 0;
+
+    // Told about every change, with mtx held so changes arrive in order.
+    // The change isn't even encoded while `wanted` says nobody is listening.
+    std::function<void(const json&)> listener;
+    std::function<bool()> wanted;
     const std::string filename = "history.json";
+    std::mutex mtx; // handlers run on httplib's worker pool
+
+    std::condition_variable wake;
+    std::chrono::milliseconds coalesce;
+    size_t pending = 0;     // changes not yet on disk
+    size_t writes = 0;
+    size_t writeErrors = 0; // failed flushes; the changes stay pending and are retried
+    double lastWriteMs = 0; // write + fsync of the last flush
+    double maxWriteMs = 0;
+    bool stopping = false;
+    std::thread writer;
 
 public:
-    void addRecord(std::string op, double res) {
-        CalcResult entry = {op, res};
-        if (history.size() >= 20) history.pop_front();
-        history.push_back(entry);
-        
+    explicit HistoryManager(size_t capacity = 20,
+                            std::chrono::milliseconds coalesce = std::chrono::milliseconds(100))
+        : history(capacity), coalesce(coalesce), writer([this] { writerLoop(); }) {
+        redoStack.reserve(history.capacity());
+        removals.reserve(history.capacity());
+    }
+
+    ~HistoryManager() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wake.notify_one();
+        writer.join();
+    }
+
+    HistoryManager(const HistoryManager&) = delete;
+    HistoryManager& operator=(const HistoryManager&) = delete;
+
+    void addRecord(Operation op, double res) {
+        std::lock_guard<std::mutex> lock(mtx);
+        history.push_back({op, res, ++seq});
+
         // Clear redo stack because a new action was taken
-        while(!redoStack.empty()) redoStack.pop();
+        redoStack.clear();
         saveToFile();
+        if (notifying()) listener(change("append", history.back()));
     }
 
     void undo() {
+        std::lock_guard<std::mutex> lock(mtx);
         if (!history.empty()) {
-            redoStack.push(history.back());
+            redoStack.push_back(history.back());
             history.pop_back();
+            recordRemoval(redoStack.back().seq, ++seq);
             saveToFile();
+            if (notifying()) listener({{"action", "undo"}, {"seq", seq}, {"removed", redoStack.back().seq}});
         }
     }
 
     void redo() {
+        std::lock_guard<std::mutex> lock(mtx);
         if (!redoStack.empty()) {
-            CalcResult entry = redoStack.top();
-            redoStack.pop();
-            if (history.size() >= 20) history.pop_front();
+            CalcResult entry = redoStack.back();
+            redoStack.pop_back();
+            entry.seq = ++seq;
             history.push_back(entry);
             saveToFile();
+            if (notifying()) listener(change("redo", entry));
         }
     }
 
-    void saveToFile() {
+private:
+    // Called with mtx held
+    bool notifying() const { return listener && (!wanted || wanted()); }
+
+    static json entryJson(const CalcResult& e) {
+        return {{"seq", e.seq}, {"op", operationName(e.operation)}, {"res", e.result}};
+    }
+
+    static json change(const char* action, const CalcResult& e) {
+        json j = entryJson(e);
+        j["action"] = action;
+        return j;
+    }
+
+    json toJson(size_t from = 0, size_t to = SIZE_MAX) const {
         json j_list = json::array();
-        for (auto& item : history) {
-            j_list.push_back({{"op", item.operation}, {"res", item.result}});
+        for (size_t i = from; i < std::min(to, history.size()); ++i) j_list.push_back(entryJson(history[i]));
+        return j_list;
+    }
+
+    void recordRemoval(uint64_t from, uint64_t at) {
+        while (!removals.empty() && removals.back().from >= from) removals.pop_back();
+        if (removals.size() == history.capacity()) {
+            forgetBelow = removals.front().at;
+            removals.erase(removals.begin());
         }
-        std::ofstream file(filename);
-        file << j_list.dump(4);
+        removals.push_back({from, at});
     }
 
+    // Whether a client holding everything up to `since` may be out of date
+    bool stale(uint64_t since) const {
+        if (since < forgetBelow || since > seq) return true;
+        auto it = std::upper_bound(removals.begin(), removals.end(), since,
+                                   [](uint64_t s, const Removal& r) { return s < r.from; });
+        return it != removals.begin() && since < std::prev(it)->at;
+    }
+
+    // Index of the first entry with seq > since; entries are in seq order
+    size_t firstAfter(uint64_t since) const {
+        size_t lo = 0, hi = history.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (history[mid].seq <= since) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Called with mtx held
+    void saveToFile() {
+        pending++;
+        wake.notify_one();
+    }
+
+    // Only the copy of the ring happens under mtx; encoding a deep history
+    // takes far longer and would stall addRecord on the request path
+    void writerLoop() {
+        std::vector<CalcResult> snapshot;
+        std::unique_lock<std::mutex> lock(mtx);
+        snapshot.reserve(history.capacity());
+        for (;;) {
+            wake.wait(lock, [this] { return pending > 0 || stopping; });
+            if (pending == 0) return;
+            if (!stopping) wake.wait_for(lock, coalesce, [this] { return stopping; });
+            history.copyTo(snapshot);
+            size_t flushed = pending;
+            lock.unlock();
+
+            json j_list = json::array();
+            for (const CalcResult& e : snapshot) j_list.push_back(entryJson(e));
+            auto start = std::chrono::steady_clock::now();
+            bool ok = DurableFile::replace(filename, j_list.dump());
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            lock.lock();
+            if (!ok) {
+                writeErrors++;
+                if (stopping) {
+                    std::cerr << filename << ": could not save history on shutdown\n";
+                    return;
+                }
+                wake.wait_for(lock, std::chrono::seconds(1), [this] { return stopping; });
+                continue;
+            }
+            pending -= flushed;
+            writes++;
+            lastWriteMs = ms;
+            if (ms > maxWriteMs) maxWriteMs = ms;
+        }
+    }
+
+public:
     void loadFromFile() {
+        std::lock_guard<std::mutex> lock(mtx);
         std::ifstream file(filename);
         if (file.is_open() && file.peek() != std::ifstream::traits_type::eof()) {
             json j_list;
             file >> j_list;
             history.clear();
             for (auto& item : j_list) {
-                history.push_back({item["op"], item["res"]});
+                // Non-finite results (e.g. nCr past DBL_MAX) are saved as null
+                double res = item["res"].is_number() ? item["res"].get<double>() : HUGE_VAL;
+                // Files written before sequence numbers get fresh ones
+                uint64_t s = item.contains("seq") ? item["seq"].get<uint64_t>() : seq + 1;
+                seq = std::max(seq + 1, s);
+                history.push_back({operationFromName(item["op"]), res, seq});
             }
         }
+        // Undos from before the restart weren't saved, so earlier cursors
+        // must resync
+        forgetBelow = seq;
+    }
+
+    void setListener(std::function<void(const json&)> fn, std::function<bool()> active = nullptr) {
+        std::lock_guard<std::mutex> lock(mtx);
+        listener = std::move(fn);
+        wanted = std::move(active);
+    }
+
+    json getWriterStatus() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return {{"queue_depth", pending}, {"writes", writes}, {"write_errors", writeErrors},
+                {"last_write_ms", lastWriteMs}, {"max_write_ms", maxWriteMs}};
     }
 
     json getHistoryAsJson() {
-        json j_list = json::array();
-        for (auto& item : history) j_list.push_back({{"op", item.operation}, {"res", item.result}});
-        return j_list;
+        std::lock_guard<std::mutex> lock(mtx);
+        return toJson();
+    }
+
+    // Up to `limit` entries starting `offset` from the oldest
+    json getPage(size_t offset, size_t limit) {
+        std::lock_guard<std::mutex> lock(mtx);
+        offset = std::min(offset, history.size());
+        size_t end = offset + std::min(limit, history.size() - offset);
+        json page = {{"seq", seq}, {"total", history.size()}, {"entries", toJson(offset, end)}};
+        if (end < history.size()) page["next_offset"] = end;
+        return page;
+    }
+
+    // Entries appended after sequence number `since`. If an undo or reload
+    // may have removed something the client has, or entries it never saw
+    // have already fallen out of the ring, "reset" is set and the entries
+    // start from the oldest. Pass "next" back as `since`.
+    json getSince(uint64_t since, size_t limit) {
+        std::lock_guard<std::mutex> lock(mtx);
+        bool gap = !history.empty() && since + 1 < history[0].seq;
+        bool reset = gap || stale(since);
+        size_t from = reset ? 0 : firstAfter(since);
+        size_t end = from + std::min(limit, history.size() - from);
+        bool more = end < history.size();
+        return {{"seq", seq}, {"reset", reset}, {"entries", toJson(from, end)},
+                {"more", more}, {"next", more ? history[end - 1].seq : seq}};
     }
 };
 
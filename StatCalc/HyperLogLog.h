@@ -0,0 +1,51 @@
+#ifndef HYPER_LOG_LOG_H
+#define HYPER_LOG_LOG_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "Hash.h"
+
+// HyperLogLog distinct counter (Flajolet et al.) with 2^precision one-byte
+// registers and linear counting for small cardinalities. Standard error is
+// about 1.04 / sqrt(2^precision); the default 14 gives ~0.8% in 16KB.
+class HyperLogLog {
+private:
+    unsigned precision;
+    std::vector<uint8_t> registers;
+
+public:
+    explicit HyperLogLog(unsigned precision = 14)
+        : precision(precision < 4 ? 4 : precision > 18 ? 18 : precision),
+          registers((size_t)1 << this->precision, 0) {}
+
+    void add(double val) {
+        uint64_t h = ValueHash::of(val);
+        size_t idx = h >> (64 - precision);
+        uint64_t rest = (h << precision) | ((uint64_t)1 << (precision - 1)); // guard bit bounds the run
+        uint8_t rank = 1;
+        while (!(rest & 0x8000000000000000ULL)) { rest <<= 1; rank++; }
+        if (rank > registers[idx]) registers[idx] = rank;
+    }
+
+    void clear() { std::fill(registers.begin(), registers.end(), 0); }
+
+    double estimate() const {
+        double m = (double)registers.size();
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t r : registers) {
+            sum += std::ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+        double alpha = 0.7213 / (1 + 1.079 / m);
+        double e = alpha * m * m / sum;
+        if (e <= 2.5 * m && zeros > 0) e = m * std::log(m / zeros);
+        return e;
+    }
+
+    double standardError() const { return 1.04 / std::sqrt((double)registers.size()); }
+    size_t bytes() const { return registers.size(); }
+};
+#endif
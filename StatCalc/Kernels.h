@@ -0,0 +1,189 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+#include <vector>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define STATCALC_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define STATCALC_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang need a per-function target to emit AVX2 without -mavx2;
+// MSVC accepts the intrinsics anywhere.
+#if defined(STATCALC_X86) && (defined(__GNUC__) || defined(__clang__))
+#define STATCALC_AVX2 __attribute__((target("avx2")))
+#else
+#define STATCALC_AVX2
+#endif
+
+// Reduction kernels over contiguous doubles. Sums are Kahan-compensated per
+// lane, so vector width changes throughput but not accuracy. The widest
+// instruction set the CPU supports is picked once, on first use.
+class Kernels {
+private:
+    struct Set {
+        double (*sum)(const double*, size_t);
+        // Compensated sums of (x - shift)^k for k = 1..4
+        void (*powerSums)(const double*, size_t, double, double*);
+        const char* name;
+    };
+
+    struct Kahan {
+        double s = 0, c = 0;
+        void add(double x) {
+            double y = x - c;
+            double t = s + y;
+            c = (t - s) - y;
+            s = t;
+        }
+    };
+
+    // --- Portable fallback ---
+    static double sumScalar(const double* p, size_t n) {
+        Kahan k;
+        for (size_t i = 0; i < n; ++i) k.add(p[i]);
+        return k.s;
+    }
+    static void powerSumsTail(const double* p, size_t n, double shift, Kahan* k) {
+        for (size_t i = 0; i < n; ++i) {
+            double d = p[i] - shift, d2 = d * d;
+            k[0].add(d);
+            k[1].add(d2);
+            k[2].add(d2 * d);
+            k[3].add(d2 * d2);
+        }
+    }
+    static void powerSumsScalar(const double* p, size_t n, double shift, double* out) {
+        Kahan k[4];
+        powerSumsTail(p, n, shift, k);
+        for (int j = 0; j < 4; ++j) out[j] = k[j].s;
+    }
+
+#if defined(STATCALC_X86)
+    // --- AVX2, 4 lanes ---
+    STATCALC_AVX2 static void kahanAdd(__m256d& s, __m256d& c, __m256d x) {
+        __m256d y = _mm256_sub_pd(x, c);
+        __m256d t = _mm256_add_pd(s, y);
+        c = _mm256_sub_pd(_mm256_sub_pd(t, s), y);
+        s = t;
+    }
+    STATCALC_AVX2 static double reduceLanes(__m256d s, Kahan tail) {
+        alignas(32) double lanes[4];
+        _mm256_store_pd(lanes, s);
+        for (double l : lanes) tail.add(l);
+        return tail.s;
+    }
+    STATCALC_AVX2 static double sumAvx2(const double* p, size_t n) {
+        __m256d s = _mm256_setzero_pd(), c = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) kahanAdd(s, c, _mm256_loadu_pd(p + i));
+        Kahan tail;
+        for (; i < n; ++i) tail.add(p[i]);
+        return reduceLanes(s, tail);
+    }
+    STATCALC_AVX2 static void powerSumsAvx2(const double* p, size_t n, double shift, double* out) {
+        __m256d s[4], c[4];
+        for (int j = 0; j < 4; ++j) s[j] = c[j] = _mm256_setzero_pd();
+        __m256d k = _mm256_set1_pd(shift);
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d d = _mm256_sub_pd(_mm256_loadu_pd(p + i), k);
+            __m256d d2 = _mm256_mul_pd(d, d);
+            kahanAdd(s[0], c[0], d);
+            kahanAdd(s[1], c[1], d2);
+            kahanAdd(s[2], c[2], _mm256_mul_pd(d2, d));
+            kahanAdd(s[3], c[3], _mm256_mul_pd(d2, d2));
+        }
+        Kahan tail[4];
+        powerSumsTail(p + i, n - i, shift, tail);
+        for (int j = 0; j < 4; ++j) out[j] = reduceLanes(s[j], tail[j]);
+    }
+
+    static bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int r[4];
+        __cpuid(r, 1);
+        bool osxsave = (r[2] & (1 << 27)) != 0, avx = (r[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(r, 7, 0);
+        return (r[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+#if defined(STATCALC_NEON)
+    // --- NEON, 2 lanes (always present on AArch64) ---
+    static void kahanAdd(float64x2_t& s, float64x2_t& c, float64x2_t x) {
+        float64x2_t y = vsubq_f64(x, c);
+        float64x2_t t = vaddq_f64(s, y);
+        c = vsubq_f64(vsubq_f64(t, s), y);
+        s = t;
+    }
+    static double reduceLanes(float64x2_t s, Kahan tail) {
+        tail.add(vgetq_lane_f64(s, 0));
+        tail.add(vgetq_lane_f64(s, 1));
+        return tail.s;
+    }
+    static double sumNeon(const double* p, size_t n) {
+        float64x2_t s = vdupq_n_f64(0), c = vdupq_n_f64(0);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) kahanAdd(s, c, vld1q_f64(p + i));
+        Kahan tail;
+        for (; i < n; ++i) tail.add(p[i]);
+        return reduceLanes(s, tail);
+    }
+    static void powerSumsNeon(const double* p, size_t n, double shift, double* out) {
+        float64x2_t s[4], c[4];
+        for (int j = 0; j < 4; ++j) s[j] = c[j] = vdupq_n_f64(0);
+        float64x2_t k = vdupq_n_f64(shift);
+        size_t i = 0;
+        for (; i + 2 <= n; i += 2) {
+            float64x2_t d = vsubq_f64(vld1q_f64(p + i), k);
+            float64x2_t d2 = vmulq_f64(d, d);
+            kahanAdd(s[0], c[0], d);
+            kahanAdd(s[1], c[1], d2);
+            kahanAdd(s[2], c[2], vmulq_f64(d2, d));
+            kahanAdd(s[3], c[3], vmulq_f64(d2, d2));
+        }
+        Kahan tail[4];
+        powerSumsTail(p + i, n - i, shift, tail);
+        for (int j = 0; j < 4; ++j) out[j] = reduceLanes(s[j], tail[j]);
+    }
+#endif
+
+    static Set pick() {
+#if defined(STATCALC_X86)
+        if (cpuHasAvx2()) return {sumAvx2, powerSumsAvx2, "avx2"};
+#elif defined(STATCALC_NEON)
+        return {sumNeon, powerSumsNeon, "neon"};
+#endif
+        return {sumScalar, powerSumsScalar, "scalar"};
+    }
+
+    static const Set& active() {
+        static const Set set = pick();
+        return set;
+    }
+
+public:
+    static const char* isa() { return active().name; }
+
+    static double sum(const double* p, size_t n) { return active().sum(p, n); }
+    static double sum(const std::vector<double>& data) { return sum(data.data(), data.size()); }
+
+    // Sums of (x - shift)^k for k = 1..4 into out[0..3]. With shift at or
+    // near the mean these are the central moment sums without the
+    // cancellation the raw power sums would suffer.
+    static void powerSums(const double* p, size_t n, double shift, double* out) {
+        active().powerSums(p, n, shift, out);
+    }
+};
+#endif
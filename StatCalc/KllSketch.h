@@ -0,0 +1,119 @@
+#ifndef KLL_SKETCH_H
+#define KLL_SKETCH_H
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <utility>
+
+// KLL quantile sketch (Karnin, Lang, Liberty 2016). A stack of compactors
+// whose capacities shrink geometrically towards the bottom; when the sketch
+// is full the lowest over-capacity level is sorted and every other item is
+// promoted one level up with doubled weight. Memory is O(k) items plus one
+// small level per doubling of the stream, independent of how much is fed in.
+class KllSketch {
+private:
+    size_t k;
+    std::vector<std::vector<double>> levels; // level h items weigh 2^h
+    size_t retained = 0;
+    size_t maxRetained = 0;
+    uint64_t n = 0;
+    std::minstd_rand rng{std::random_device{}()};
+    static constexpr double shrink = 2.0 / 3.0;
+
+    size_t capacity(size_t h) const {
+        size_t depth = levels.size() - h - 1;
+        return (size_t)std::ceil(k * std::pow(shrink, (double)depth)) + 1;
+    }
+
+    void grow() {
+        levels.emplace_back();
+        maxRetained = 0;
+        for (size_t h = 0; h < levels.size(); ++h) maxRetained += capacity(h);
+    }
+
+    // Compacts only the lowest full level, which is enough to make room
+    void compress() {
+        for (size_t h = 0; h < levels.size(); ++h) {
+            if (levels[h].size() < capacity(h)) continue;
+            if (h + 1 == levels.size()) grow();
+            std::vector<double>& cur = levels[h];
+            std::vector<double>& up = levels[h + 1];
+            std::sort(cur.begin(), cur.end());
+            size_t keep = cur.size() % 2; // an odd item out stays behind
+            size_t offset = keep + (rng() & 1);
+            for (size_t i = offset; i < cur.size(); i += 2) up.push_back(cur[i]);
+            double leftover = cur[0];
+            retained -= cur.size() - keep;
+            retained += (cur.size() - keep) / 2;
+            cur.clear();
+            if (keep) cur.push_back(leftover);
+            return;
+        }
+    }
+
+    // (value, weight) pairs sorted by value
+    std::vector<std::pair<double, uint64_t>> weighted() const {
+        std::vector<std::pair<double, uint64_t>> items;
+        items.reserve(retained);
+        for (size_t h = 0; h < levels.size(); ++h)
+            for (double v : levels[h]) items.push_back({v, (uint64_t)1 << h});
+        std::sort(items.begin(), items.end());
+        return items;
+    }
+
+public:
+    explicit KllSketch(size_t k = 200) : k(std::max<size_t>(k, 8)) { grow(); }
+
+    // Smallest k whose normalized rank error stays within eps, for eps in
+    // (0, 1). Capped so a vanishing eps can't overflow the conversion.
+    static size_t kForError(double eps) {
+        return (size_t)std::min(std::ceil(std::pow(2.296 / eps, 1.0 / 0.9723)), 1e9);
+    }
+
+    void add(double val) {
+        levels[0].push_back(val);
+        retained++;
+        n++;
+        if (retained >= maxRetained) compress();
+    }
+
+    void clear() {
+        levels.clear();
+        retained = 0;
+        n = 0;
+        grow();
+    }
+
+    uint64_t count() const { return n; }
+    size_t retainedItems() const { return retained; }
+    size_t levelCount() const { return levels.size(); }
+    size_t getK() const { return k; }
+    size_t bytes() const {
+        size_t b = sizeof(*this);
+        for (const auto& l : levels) b += l.capacity() * sizeof(double);
+        return b;
+    }
+
+    // Normalized rank error at 99% confidence, from the empirical fit used
+    // by Apache DataSketches for this compactor schedule
+    double rankError() const { return 2.296 / std::pow((double)k, 0.9723); }
+
+    // Approximate value at rank q * (n - 1), q in [0, 1]
+    double quantile(double q) const {
+        if (n == 0) return 0;
+        auto items = weighted();
+        uint64_t total = 0;
+        for (auto& it : items) total += it.second;
+        double target = std::min(1.0, std::max(0.0, q)) * (total - 1);
+        uint64_t cum = 0;
+        for (auto& it : items) {
+            cum += it.second;
+            if (cum > target) return it.first;
+        }
+        return items.back().first;
+    }
+};
+#endif
@@ -0,0 +1,85 @@
+#ifndef MODE_INDEX_H
+#define MODE_INDEX_H
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "Hash.h"
+
+// value -> count index that keeps the current mode set up to date on every
+// insert. Counts only ever grow (values are never removed individually), so
+// the set of values at the max frequency is all that needs tracking.
+//
+// Counts live in a linear-probing table hashed with ValueHash: two flat
+// arrays, doubled when half full and released in one go by clear().
+// Only the smallest maxListed modes are kept (ascending); modeCount() says
+// how many values are tied in total.
+class ModeIndex {
+public:
+    static constexpr size_t maxListed = 100;
+
+private:
+    std::vector<double> keys;
+    std::vector<size_t> counts; // 0 marks an empty slot
+    size_t used = 0;
+    std::vector<double> modes; // smallest values whose count == maxFreq
+    size_t tied = 0;
+    size_t maxFreq = 0;
+
+    void grow() {
+        std::vector<double> oldKeys = std::move(keys);
+        std::vector<size_t> oldCounts = std::move(counts);
+        size_t cap = std::max<size_t>(16, oldKeys.size() * 2);
+        keys.assign(cap, 0);
+        counts.assign(cap, 0);
+        for (size_t j = 0; j < oldKeys.size(); ++j) {
+            if (!oldCounts[j]) continue;
+            size_t i = ValueHash::of(oldKeys[j]) & (cap - 1);
+            while (counts[i]) i = (i + 1) & (cap - 1);
+            keys[i] = oldKeys[j];
+            counts[i] = oldCounts[j];
+        }
+    }
+
+    size_t& countOf(double val) {
+        if ((used + 1) * 2 > keys.size()) grow();
+        size_t mask = keys.size() - 1;
+        size_t i = ValueHash::of(val) & mask;
+        while (counts[i] && keys[i] != val) i = (i + 1) & mask;
+        if (!counts[i]) { keys[i] = val; used++; }
+        return counts[i];
+    }
+
+public:
+    void add(double val) {
+        val = ValueHash::normalize(val);
+        size_t c = ++countOf(val);
+        if (c > maxFreq) {
+            maxFreq = c;
+            modes.clear();
+            tied = 0;
+        }
+        if (c == maxFreq) {
+            tied++;
+            if (modes.size() < maxListed || val < modes.back()) {
+                modes.insert(std::upper_bound(modes.begin(), modes.end(), val), val);
+                if (modes.size() > maxListed) modes.pop_back();
+            }
+        }
+    }
+
+    void clear() {
+        std::vector<double>().swap(keys);
+        std::vector<size_t>().swap(counts);
+        used = 0;
+        modes.clear();
+        tied = 0;
+        maxFreq = 0;
+    }
+
+    const std::vector<double>& getModes() const { return modes; }
+    size_t modeCount() const { return tied; }
+    size_t frequency() const { return maxFreq; }
+    double smallestMode() const { return modes.empty() ? 0 : modes[0]; }
+    size_t distinct() const { return used; }
+};
+#endif
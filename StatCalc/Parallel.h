@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+#include <vector>
+#include <cstddef>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+// Fork-join helper for splitting large reductions across cores. Inputs below
+// the threshold stay on the calling thread, where spawning would cost more
+// than it saves.
+class Parallel {
+private:
+    static std::atomic<size_t>& thresholdRef() {
+        static std::atomic<size_t> t{1 << 20};
+        return t;
+    }
+    static std::atomic<unsigned>& threadsRef() {
+        static std::atomic<unsigned> t{std::max(1u, std::thread::hardware_concurrency())};
+        return t;
+    }
+
+public:
+    static size_t threshold() { return thresholdRef(); }
+    static void setThreshold(size_t n) { thresholdRef() = n; }
+    static unsigned threads() { return threadsRef(); }
+    static void setThreads(unsigned n) { threadsRef() = std::max(1u, n); }
+
+    // Number of chunks to split n elements into under the current settings
+    static unsigned chunksFor(size_t n) {
+        if (n < threshold() || threads() < 2) return 1;
+        return (unsigned)std::min<size_t>(threads(), n);
+    }
+
+    // Calls fn(chunk, begin, end) over `chunks` contiguous slices of [0, n),
+    // one per thread, and waits for all of them. The calling thread takes
+    // chunk 0. Callers pass the chunksFor() value they sized their per-chunk
+    // state with, since the settings can change between two calls.
+    template <typename Fn>
+    static void forChunks(unsigned chunks, size_t n, Fn fn) {
+        std::vector<std::thread> workers;
+        workers.reserve(chunks - 1);
+        for (unsigned c = 1; c < chunks; ++c)
+            workers.emplace_back(fn, c, n * c / chunks, n * (c + 1) / chunks);
+        fn(0u, (size_t)0, n / chunks);
+        for (auto& w : workers) w.join();
+    }
+};
+#endif
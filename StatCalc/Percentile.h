@@ -0,0 +1,26 @@
+#ifndef PERCENTILE_H
+#define PERCENTILE_H
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+// The one percentile definition every exact backend answers with: p in
+// [0, 100] (clamped), linearly interpolated between the closest ranks.
+struct Percentile {
+    // `at(k)` returns the k-th smallest (0-based) of n values; 0 when n == 0
+    template <class At>
+    static double interpolate(size_t n, double p, At at) {
+        if (n == 0) return 0;
+        double pos = std::min(100.0, std::max(0.0, p)) / 100.0 * (n - 1);
+        size_t lo = (size_t)pos;
+        double frac = pos - lo;
+        double a = at(lo);
+        if (frac == 0 || lo + 1 >= n) return a;
+        return a + (at(lo + 1) - a) * frac;
+    }
+
+    static double sorted(const std::vector<double>& data, double p) {
+        return interpolate(data.size(), p, [&](size_t k) { return data[k]; });
+    }
+};
+#endif
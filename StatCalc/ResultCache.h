@@ -0,0 +1,122 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+#include <list>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+#include "json.hpp"
+#include "Hash.h"
+#include "HistoryManager.h"
+
+using json = nlohmann::json;
+
+// Bounded LRU memo for the deterministic probability endpoints. Entries hold
+// the encoded response body, so a hit skips both the math and the JSON
+// encoding. Keys are spread over shards with their own lock and LRU list, so
+// concurrent lookups rarely contend. The capacity is split exactly across
+// the shards (never more shards than entries), so it is a hard bound.
+class ResultCache {
+public:
+    struct Key {
+        Operation op;
+        int64_t a, b;
+        double p; // 0 when unused
+        bool exact;
+        bool operator==(const Key& o) const {
+            return op == o.op && a == o.a && b == o.b && p == o.p && exact == o.exact;
+        }
+    };
+
+    struct Entry {
+        double result;
+        int status; // 200, or the error status to repeat
+        std::string body;
+    };
+
+private:
+    struct KeyHash {
+        static uint64_t of(const Key& k) {
+            uint64_t h = ValueHash::mix((uint64_t)k.op << 1 | k.exact);
+            h = ValueHash::mix(h ^ (uint64_t)k.a);
+            h = ValueHash::mix(h ^ (uint64_t)k.b);
+            return h ^ ValueHash::of(k.p);
+        }
+        size_t operator()(const Key& k) const { return (size_t)of(k); }
+    };
+
+    using Item = std::pair<Key, std::shared_ptr<const Entry>>;
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<Item> lru; // most recently used first
+        std::unordered_map<Key, std::list<Item>::iterator, KeyHash> index;
+        size_t limit = 0;
+        size_t hits = 0, misses = 0;
+    };
+
+    size_t capacity;
+    std::vector<Shard> shards;
+
+    // The map buckets on the low bits (modulo on libstdc++, a mask on MSVC),
+    // so the shard comes from the top bits; otherwise every key in a shard
+    // would share its low bits and crowd into a fraction of the buckets.
+    Shard& shardFor(const Key& k) {
+        uint64_t h = KeyHash::of(k);
+        return shards[(size_t)((h >> 32) * shards.size() >> 32)];
+    }
+
+public:
+    // capacity 0 disables caching
+    explicit ResultCache(size_t capacity, size_t shardCount = 16)
+        : capacity(capacity), shards(std::max<size_t>(1, std::min(shardCount, capacity))) {
+        for (size_t i = 0; i < shards.size(); ++i)
+            shards[i].limit = capacity / shards.size() + (i < capacity % shards.size());
+    }
+
+    // Null on a miss
+    std::shared_ptr<const Entry> get(const Key& k) {
+        Shard& s = shardFor(k);
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto it = s.index.find(k);
+        if (it == s.index.end()) { s.misses++; return nullptr; }
+        s.hits++;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return it->second->second;
+    }
+
+    std::shared_ptr<const Entry> put(const Key& k, Entry e) {
+        auto entry = std::make_shared<const Entry>(std::move(e));
+        Shard& s = shardFor(k);
+        if (s.limit == 0) return entry;
+        std::lock_guard<std::mutex> lock(s.mtx);
+        auto it = s.index.find(k);
+        if (it != s.index.end()) { // another request computed it meanwhile
+            s.lru.splice(s.lru.begin(), s.lru, it->second);
+            return it->second->second;
+        }
+        s.lru.emplace_front(k, entry);
+        s.index[k] = s.lru.begin();
+        if (s.lru.size() > s.limit) {
+            s.index.erase(s.lru.back().first);
+            s.lru.pop_back();
+        }
+        return entry;
+    }
+
+    json status() {
+        size_t hits = 0, misses = 0, size = 0;
+        for (Shard& s : shards) {
+            std::lock_guard<std::mutex> lock(s.mtx);
+            hits += s.hits;
+            misses += s.misses;
+            size += s.lru.size();
+        }
+        return {{"hits", hits}, {"misses", misses}, {"size", size},
+                {"capacity", capacity}, {"shards", shards.size()}};
+    }
+};
+#endif
@@ -0,0 +1,45 @@
+#ifndef RUNNING_STATS_H
+#define RUNNING_STATS_H
+#include <cstddef>
+#include <cmath>
+#include <limits>
+
+// Welford's online mean/variance, updated one value at a time
+struct RunningStats {
+    size_t n = 0;
+    double mean = 0;
+    double m2 = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+
+    void add(double x) {
+        n++;
+        double delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+        if (x < min) min = x;
+        if (x > max) max = x;
+    }
+
+    // Chan et al. pairwise combination, for partial states built in parallel
+    void merge(const RunningStats& o) {
+        if (o.n == 0) return;
+        if (n == 0) { *this = o; return; }
+        size_t total = n + o.n;
+        double delta = o.mean - mean;
+        mean += delta * o.n / total;
+        m2 += o.m2 + delta * delta * ((double)n * o.n / total);
+        n = total;
+        if (o.min < min) min = o.min;
+        if (o.max > max) max = o.max;
+    }
+
+    void reset() { *this = RunningStats(); }
+
+    double getMean() const { return n ? mean : 0; }
+    // Population variance, matching Summary::variance
+    double variance() const { return n < 2 ? 0 : m2 / n; }
+    double sampleVariance() const { return n < 2 ? 0 : m2 / (n - 1); }
+    double stdDev() const { return std::sqrt(variance()); }
+};
+#endif
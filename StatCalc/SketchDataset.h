@@ -0,0 +1,74 @@
+#ifndef SKETCH_DATASET_H
+#define SKETCH_DATASET_H
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include "RunningStats.h"
+#include "KllSketch.h"
+#include "HeavyHitters.h"
+#include "HyperLogLog.h"
+
+// Bounded-memory dataset for unbounded streams. Count, mean, variance, min
+// and max stay exact through RunningStats; median and percentiles come from
+// a KLL sketch, approximate mode from Space-Saving heavy hitters and the
+// distinct count from HyperLogLog. Individual points are not kept, so the
+// raw dataset and the exact summary are unavailable in this mode.
+class SketchDataset {
+private:
+    KllSketch sketch;
+    HeavyHitters hitters;
+    HyperLogLog distinct;
+    RunningStats stats;
+    unsigned long long version = 0;
+
+public:
+    static constexpr bool exact = false;
+
+    // eps is the target normalized rank error of percentile answers
+    explicit SketchDataset(double eps = 0.01) : sketch(KllSketch::kForError(eps)) {}
+
+    void add(double val) {
+        sketch.add(val);
+        hitters.add(val);
+        distinct.add(val);
+        stats.add(val);
+        version++;
+    }
+
+    void addBatch(const std::vector<double>& vals) {
+        if (vals.empty()) return;
+        for (double v : vals) {
+            sketch.add(v);
+            hitters.add(v);
+            distinct.add(v);
+            stats.add(v);
+        }
+        version++;
+    }
+
+    void clear() {
+        sketch.clear();
+        hitters.clear();
+        distinct.clear();
+        stats.reset();
+        version++;
+    }
+
+    const RunningStats& getStats() const { return stats; }
+    const KllSketch& getSketch() const { return sketch; }
+    const HeavyHitters& getHeavyHitters() const { return hitters; }
+    const HyperLogLog& getDistinct() const { return distinct; }
+    unsigned long long getVersion() const { return version; }
+    size_t count() const { return stats.n; }
+
+    // p in [0, 100]; the extremes are exact
+    double percentile(double p) const {
+        if (stats.n == 0) return 0;
+        if (p <= 0) return stats.min;
+        if (p >= 100) return stats.max;
+        return std::min(stats.max, std::max(stats.min, sketch.quantile(p / 100.0)));
+    }
+
+    double median() const { return percentile(50); }
+};
+#endif
@@ -0,0 +1,152 @@
+#ifndef SLIDING_WINDOW_H
+#define SLIDING_WINDOW_H
+#include <deque>
+#include <set>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <iterator>
+
+// Rolling statistics over the most recent N points or the last T seconds.
+// Nothing is rescanned per query:
+//   mean/variance  Welford updates applied forwards on arrival, backwards on expiry
+//   min/max        monotonic deques of (sequence, value)
+//   median         ordered set of (value, sequence) with an iterator at the
+//                  lower median, stepped at most once per insert or erase
+// Expiry is time-driven too, so every call takes the window's own lock.
+class SlidingWindow {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        size_t count = 0;
+        double mean = 0, variance = 0, stdDev = 0, min = 0, max = 0, median = 0;
+    };
+
+private:
+    struct Point { Clock::time_point at; unsigned long long seq; double value; };
+
+    size_t maxCount;          // 0 = no count limit
+    Clock::duration maxAge;   // zero = no age limit
+    std::deque<Point> points;
+    unsigned long long nextSeq = 0;
+    std::mutex mtx;
+
+    size_t n = 0;
+    double mean = 0, m2 = 0;
+    std::deque<Point> minQ, maxQ;
+
+    // The sequence number makes every key unique, so an expiring point is
+    // erased exactly and its position relative to `mid` is unambiguous.
+    // `mid` is the element at index (size - 1) / 2.
+    using Key = std::pair<double, unsigned long long>;
+    std::set<Key> ordered;
+    std::set<Key>::iterator mid;
+
+    void insertOrdered(const Key& key) {
+        size_t m = ordered.size();
+        ordered.insert(key);
+        if (m == 0) { mid = ordered.begin(); return; }
+        bool before = key < *mid;
+        if (m % 2 == 1 && before) --mid;
+        else if (m % 2 == 0 && !before) ++mid;
+    }
+
+    void eraseOrdered(const Key& key) {
+        size_t m = ordered.size();
+        if (m == 1) { ordered.clear(); return; }
+        if (key == *mid) {
+            if (m % 2 == 1) --mid; else ++mid;
+        } else if (key < *mid) {
+            if (m % 2 == 0) ++mid;
+        } else if (m % 2 == 1) {
+            --mid;
+        }
+        ordered.erase(key);
+    }
+
+    void push(const Point& p) {
+        double x = p.value;
+        n++;
+        double delta = x - mean;
+        mean += delta / n;
+        m2 += delta * (x - mean);
+
+        while (!minQ.empty() && minQ.back().value >= x) minQ.pop_back();
+        minQ.push_back(p);
+        while (!maxQ.empty() && maxQ.back().value <= x) maxQ.pop_back();
+        maxQ.push_back(p);
+
+        insertOrdered({x, p.seq});
+    }
+
+    void pop() {
+        const Point& p = points.front();
+        double x = p.value;
+        if (n == 1) { n = 0; mean = m2 = 0; }
+        else {
+            n--;
+            double delta = x - mean;
+            mean -= delta / n;
+            m2 = std::max(0.0, m2 - delta * (x - mean));
+        }
+
+        if (minQ.front().seq == p.seq) minQ.pop_front();
+        if (maxQ.front().seq == p.seq) maxQ.pop_front();
+
+        eraseOrdered({x, p.seq});
+        points.pop_front();
+    }
+
+    void expire(Clock::time_point now) {
+        while (!points.empty() &&
+               ((maxCount && points.size() > maxCount) ||
+                (maxAge.count() && now - points.front().at > maxAge)))
+            pop();
+    }
+
+public:
+    SlidingWindow(size_t maxCount, Clock::duration maxAge) : maxCount(maxCount), maxAge(maxAge) {}
+
+    bool enabled() const { return maxCount || maxAge.count(); }
+
+    void add(double val) { add(std::vector<double>{val}); }
+
+    void add(const std::vector<double>& vals) {
+        std::lock_guard<std::mutex> lock(mtx);
+        Clock::time_point now = Clock::now();
+        for (double v : vals) {
+            points.push_back({now, nextSeq++, v});
+            push(points.back());
+        }
+        expire(now);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mtx);
+        points.clear();
+        minQ.clear(); maxQ.clear();
+        ordered.clear();
+        n = 0; mean = m2 = 0;
+    }
+
+    // Population variance, matching the all-time statistics
+    Snapshot snapshot() {
+        std::lock_guard<std::mutex> lock(mtx);
+        expire(Clock::now());
+        Snapshot s;
+        s.count = n;
+        if (n == 0) return s;
+        s.mean = mean;
+        s.variance = n < 2 ? 0 : m2 / n;
+        s.stdDev = std::sqrt(s.variance);
+        s.min = minQ.front().value;
+        s.max = maxQ.front().value;
+        s.median = n % 2 == 1 ? mid->first : (mid->first + std::next(mid)->first) / 2.0;
+        return s;
+    }
+};
+#endif
@@ -0,0 +1,107 @@
+#ifndef STREAM_HUB_H
+#define STREAM_HUB_H
+#include <deque>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <condition_variable>
+#include "json.hpp"
+
+using json = nlohmann::json;
+
+// Fan-out for the server-sent event stream. Each event is encoded once and
+// shared by every subscriber's queue. Queues are bounded: a client that
+// can't keep up has its backlog dropped and receives a single "reset"
+// event instead, after which it should refetch (e.g. /history?since=).
+class StreamHub {
+public:
+    using Message = std::shared_ptr<const std::string>;
+
+    struct Subscriber {
+        std::deque<Message> queue;
+        bool lagged = false;
+    };
+
+private:
+    size_t maxClients;
+    size_t queueDepth;
+    std::vector<std::shared_ptr<Subscriber>> subscribers;
+    size_t published = 0;
+    size_t dropped = 0; // messages discarded from lagging queues
+    bool closed = false;
+    std::mutex mtx;
+    std::condition_variable ready;
+
+public:
+    StreamHub(size_t maxClients, size_t queueDepth = 256)
+        : maxClients(maxClients), queueDepth(queueDepth > 0 ? queueDepth : 1) {}
+
+    // Null when maxClients are already connected
+    std::shared_ptr<Subscriber> subscribe() {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (subscribers.size() >= maxClients) return nullptr;
+        subscribers.push_back(std::make_shared<Subscriber>());
+        return subscribers.back();
+    }
+
+    void unsubscribe(const std::shared_ptr<Subscriber>& sub) {
+        std::lock_guard<std::mutex> lock(mtx);
+        subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), sub), subscribers.end());
+    }
+
+    size_t clients() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return subscribers.size();
+    }
+
+    void publish(const std::string& event, const json& data) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (subscribers.empty()) return;
+        Message msg = std::make_shared<const std::string>("event: " + event + "\ndata: " + data.dump() + "\n\n");
+        for (auto& sub : subscribers) {
+            if (sub->queue.size() >= queueDepth) {
+                dropped += sub->queue.size();
+                sub->queue.clear();
+                sub->lagged = true;
+            }
+            if (sub->lagged) dropped++;
+            else sub->queue.push_back(msg);
+        }
+        published++;
+        ready.notify_all();
+    }
+
+    // Wakes every waiting next() for good; used at shutdown
+    void close() {
+        std::lock_guard<std::mutex> lock(mtx);
+        closed = true;
+        ready.notify_all();
+    }
+
+    // Waits up to `timeout` for the next message for `sub`; null on timeout
+    // or once the hub is closed
+    Message next(Subscriber& sub, std::chrono::milliseconds timeout) {
+        static const Message reset = std::make_shared<const std::string>("event: reset\ndata: {}\n\n");
+        std::unique_lock<std::mutex> lock(mtx);
+        ready.wait_for(lock, timeout, [&] { return closed || sub.lagged || !sub.queue.empty(); });
+        if (closed) return nullptr;
+        if (sub.lagged) {
+            sub.lagged = false;
+            return reset;
+        }
+        if (sub.queue.empty()) return nullptr;
+        Message msg = sub.queue.front();
+        sub.queue.pop_front();
+        return msg;
+    }
+
+    json status() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return {{"clients", subscribers.size()}, {"max_clients", maxClients},
+                {"queue_depth", queueDepth}, {"published", published}, {"dropped", dropped}};
+    }
+};
+#endif
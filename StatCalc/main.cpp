@@ -5,37 +5,64 @@
 #include "httplib.h"
 #include "json.hpp"
 #include "BST.h"
+#include "FlatDataset.h"
+#include "SketchDataset.h"
 #include "Calculator.h"
 #include "HistoryManager.h"
+#include "DatasetStore.h"
+#include "SlidingWindow.h"
+#include "StreamHub.h"
+#include "ResultCache.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <string>
+#include <cstring>
+#include <cmath>
+#include <shared_mutex>
+#include <csignal>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 
 using namespace httplib;
 using json = nlohmann::json;
 
-void saveCurrentBST(const std::vector<double>& data) {
-    std::ofstream file("dataset.json");
-    file << json(data).dump(4);
-}
+// Statistics handlers share the dataset; ingest and clear take it exclusively
+using ReadLock = std::shared_lock<std::shared_mutex>;
+using WriteLock = std::unique_lock<std::shared_mutex>;
 
-std::vector<double> loadCurrentBST() {
-    std::ifstream file("dataset.json");
-    if (file.is_open() && file.peek() != std::ifstream::traits_type::eof()) {
-        json j; file >> j;
-        return j.get<std::vector<double>>();
-    }
-    return {};
+// Ctrl+C / SIGTERM stop the listener so run() returns and destructors get
+// to flush pending history. stopRequested latches only once stop() has
+// acted on a running server: a second stop() while listen() drains would
+// trip httplib's assert and abort. A signal before that only sets
+// signalled, which run() checks between binding and listening.
+Server* activeServer = nullptr;
+std::atomic<bool> signalled{false};
+std::atomic<bool> stopRequested{false};
+void stopServer(int) {
+    signalled = true;
+    if (activeServer && activeServer->is_running() && !stopRequested.exchange(true)) activeServer->stop();
 }
 
-int main() {
+// Dataset is BST, FlatDataset or SketchDataset; all expose the same
+// add/clear/stats/percentile surface. Only exact ones (Dataset::exact) keep
+// every point, which persistence, /dataset, mode and summary rely on.
+// The sliding window is independent of the backend and fed alongside it.
+template <typename Dataset, typename... Args>
+int run(SlidingWindow& window, size_t historyDepth, size_t streamClients, size_t cacheSize, Args... args) {
     Server svr;
-    BST dataset;
-    HistoryManager history;
+    Dataset dataset(args...);
+    HistoryManager history(historyDepth);
+    StreamHub hub(streamClients);
+    ResultCache cache(cacheSize);
+    DatasetStore store;
+    std::shared_mutex dataMutex; // guards dataset and store
 
-    std::vector<double> startData = loadCurrentBST();
-    for(double d : startData) dataset.add(d);
+    if constexpr (Dataset::exact) {
+        try { dataset.addBatch(store.load()); }
+        catch (const std::exception& e) { std::cerr << e.what() << std::endl; return 1; }
+    }
     history.loadFromFile();
 
     svr.set_default_headers({
@@ -46,61 +73,301 @@ int main() {
     svr.Options(R"(.*)", [](const Request&, Response& res) { res.status = 200; });
 
     // --- DATASET ---
+    // Values are applied only once they're in the log. A failed append gets
+    // 500 and a compaction, which starts a fresh log if the disk recovered.
+    auto notPersisted = [&](Response& res) {
+        if constexpr (Dataset::exact) store.compact(dataset.getSorted());
+        res.status = 500;
+        res.set_content("could not persist", "text/plain");
+    };
     svr.Post("/add-data", [&](const Request& req, Response& res) {
         auto j = json::parse(req.body);
-        dataset.add(j["value"]);
-        saveCurrentBST(dataset.getSorted());
+        double v = j["value"];
+        if (!std::isfinite(v)) { res.status = 400; return; }
+        WriteLock lock(dataMutex);
+        if constexpr (Dataset::exact) {
+            if (!store.append(v)) { notPersisted(res); return; }
+        }
+        window.add(v);
+        dataset.add(v);
+        if constexpr (Dataset::exact) {
+            if (store.shouldCompact()) store.compact(dataset.getSorted());
+        }
         res.set_content("ok", "text/plain");
     });
-    svr.Get("/dataset", [&](const Request&, Response& res) {
-        res.set_content(json(dataset.getSorted()).dump(), "application/json");
+    // Body is either a JSON array (bare or as {"values": [...]}) or, with
+    // Content-Type application/octet-stream, packed little-endian doubles.
+    // NaN and infinities are rejected: they break ordering and persistence.
+    svr.Post("/add-data/batch", [&](const Request& req, Response& res) {
+        std::vector<double> vals;
+        try {
+            if (req.get_header_value("Content-Type") == "application/octet-stream") {
+                if (req.body.size() % sizeof(double) != 0) { res.status = 400; return; }
+                vals.resize(req.body.size() / sizeof(double));
+                std::memcpy(vals.data(), req.body.data(), req.body.size());
+            } else {
+                auto j = json::parse(req.body);
+                vals = (j.is_array() ? j : j["values"]).get<std::vector<double>>();
+            }
+        } catch (...) { res.status = 400; return; }
+        for (double v : vals)
+            if (!std::isfinite(v)) { res.status = 400; return; }
+        WriteLock lock(dataMutex);
+        if constexpr (Dataset::exact) {
+            if (!store.append(vals)) { notPersisted(res); return; }
+        }
+        window.add(vals);
+        dataset.addBatch(vals);
+        if constexpr (Dataset::exact) {
+            if (store.shouldCompact()) store.compact(dataset.getSorted());
+        }
+        res.set_content(json({{"added", vals.size()}}).dump(), "application/json");
+    });
+    // Serialized body is reused until the dataset version changes
+    std::string datasetBody;
+    unsigned long long datasetBodyVersion = ~0ULL;
+    std::mutex datasetBodyMutex;
+    if constexpr (Dataset::exact) svr.Get("/dataset", [&](const Request&, Response& res) {
+        ReadLock lock(dataMutex);
+        std::lock_guard<std::mutex> bodyLock(datasetBodyMutex);
+        if (datasetBodyVersion != dataset.getVersion()) {
+            datasetBody = json(dataset.getSorted()).dump();
+            datasetBodyVersion = dataset.getVersion();
+        }
+        res.set_content(datasetBody, "application/json");
     });
     svr.Post("/clear", [&](const Request&, Response& res) {
-        dataset.clear(); saveCurrentBST({});
+        WriteLock lock(dataMutex);
+        if constexpr (Dataset::exact) {
+            if (!store.compact({})) { res.status = 500; res.set_content("could not persist", "text/plain"); return; }
+        }
+        window.clear();
+        dataset.clear();
         res.set_content("ok", "text/plain");
     });
 
     // --- STANDARD STATS ---
-    svr.Get("/calculate/mean", [&](const Request&, Response& res) {
-        double v = Calculator::getMean(dataset.getSorted());
-        history.addRecord("Mean", v);
-        res.set_content(json({{"result", v}}).dump(), "application/json");
+    // mean, median and sd take ?window=1 to answer over the sliding window
+    // configured at startup instead of the whole dataset. Any other window
+    // value, or window on another endpoint, is a 400 rather than a silent
+    // all-time answer.
+    svr.set_pre_routing_handler([](const Request& req, Response& res) {
+        if (!req.has_param("window")) return Server::HandlerResponse::Unhandled;
+        bool supported = req.path == "/calculate/mean" || req.path == "/calculate/median" || req.path == "/calculate/sd";
+        if (supported && req.get_param_value("window") == "1") return Server::HandlerResponse::Unhandled;
+        res.status = 400;
+        res.set_content("window=1 is only accepted by /calculate/mean, /median and /sd", "text/plain");
+        return Server::HandlerResponse::Handled;
     });
-    svr.Get("/calculate/median", [&](const Request&, Response& res) {
-        double v = Calculator::getMedian(dataset.getSorted());
-        history.addRecord("Median", v);
+    auto windowed = [](const Request& req) { return req.has_param("window"); };
+    svr.Get("/calculate/mean", [&](const Request& req, Response& res) {
+        double v;
+        if (windowed(req)) {
+            if (!window.enabled()) { res.status = 400; return; }
+            v = window.snapshot().mean;
+        } else {
+            ReadLock lock(dataMutex);
+            v = dataset.getStats().getMean();
+        }
+        history.addRecord(Operation::Mean, v);
         res.set_content(json({{"result", v}}).dump(), "application/json");
     });
-    svr.Get("/calculate/mode", [&](const Request&, Response& res) {
-        auto m = Calculator::getMode(dataset.getSorted());
-        double v = m.empty() ? 0 : m[0];
-        history.addRecord("Mode", v);
+    svr.Get("/calculate/median", [&](const Request& req, Response& res) {
+        double v;
+        if (windowed(req)) {
+            if (!window.enabled()) { res.status = 400; return; }
+            v = window.snapshot().median;
+        } else {
+            ReadLock lock(dataMutex);
+            v = dataset.median();
+        }
+        history.addRecord(Operation::Median, v);
         res.set_content(json({{"result", v}}).dump(), "application/json");
     });
-    svr.Get("/calculate/sd", [&](const Request&, Response& res) {
-        double v = Calculator::getStandardDeviation(dataset.getSorted());
-        history.addRecord("Std Dev", v);
+    svr.Get("/calculate/percentile", [&](const Request& req, Response& res) {
+        try {
+            std::string arg = req.get_param_value("p");
+            size_t used = 0;
+            double p = std::stod(arg, &used);
+            // Trailing junk ("50abc") and nan are errors, not 50 and the minimum
+            if (used != arg.size() || !std::isfinite(p) || p < 0 || p > 100) { res.status = 400; return; }
+            double v;
+            { ReadLock lock(dataMutex); v = dataset.percentile(p); }
+            history.addRecord(Operation::Percentile, v);
+            res.set_content(json({{"result", v}}).dump(), "application/json");
+        } catch (...) { res.status = 400; }
+    });
+    // Exact datasets always answer from the mode index: the smallest tied
+    // values in ascending order, at most ModeIndex::maxListed of them, with
+    // "mode_count" giving the full number of ties. In sketch mode only
+    // ?approx=1 is available, answered from the heavy-hitter counters with
+    // `error` bounding how far each frequency may be overcounted.
+    svr.Get("/calculate/mode", [&](const Request& req, Response& res) {
+        json body;
+        {
+            ReadLock lock(dataMutex);
+            if constexpr (Dataset::exact) {
+                const ModeIndex& idx = dataset.getModeIndex();
+                body = {{"result", idx.smallestMode()}, {"modes", idx.getModes()},
+                        {"mode_count", idx.modeCount()}, {"frequency", idx.frequency()}};
+            } else {
+                if (req.get_param_value("approx") != "1") {
+                    res.status = 501;
+                    res.set_content("exact mode not available in sketch mode, use approx=1", "text/plain");
+                    return;
+                }
+                const HeavyHitters& hh = dataset.getHeavyHitters();
+                std::vector<double> modes;
+                uint64_t freq = 0;
+                for (const auto& e : hh.top()) {
+                    if (e.count < freq) break;
+                    freq = e.count;
+                    modes.push_back(e.value);
+                }
+                body = {{"result", modes.empty() ? 0.0 : modes[0]}, {"modes", modes},
+                        {"frequency", freq}, {"error", hh.maxError()}, {"approx", true}};
+            }
+        }
+        history.addRecord(Operation::Mode, body["result"]);
+        res.set_content(body.dump(), "application/json");
+    });
+    svr.Get("/calculate/distinct", [&](const Request&, Response& res) {
+        json body;
+        {
+            ReadLock lock(dataMutex);
+            if constexpr (Dataset::exact) {
+                body = {{"result", dataset.getModeIndex().distinct()}};
+            } else {
+                const HyperLogLog& hll = dataset.getDistinct();
+                body = {{"result", std::llround(hll.estimate())}, {"error", hll.standardError()}, {"approx", true}};
+            }
+        }
+        history.addRecord(Operation::Distinct, body["result"]);
+        res.set_content(body.dump(), "application/json");
+    });
+    svr.Get("/calculate/sd", [&](const Request& req, Response& res) {
+        double v;
+        if (windowed(req)) {
+            if (!window.enabled()) { res.status = 400; return; }
+            v = window.snapshot().stdDev;
+        } else {
+            ReadLock lock(dataMutex);
+            v = dataset.getStats().stdDev();
+        }
+        history.addRecord(Operation::StdDev, v);
         res.set_content(json({{"result", v}}).dump(), "application/json");
     });
 
+    auto windowJson = [&] {
+        SlidingWindow::Snapshot s = window.snapshot();
+        return json({
+            {"count", s.count}, {"mean", s.mean}, {"variance", s.variance}, {"sd", s.stdDev},
+            {"min", s.min}, {"max", s.max}, {"median", s.median}
+        });
+    };
+    svr.Get("/calculate/window", [&](const Request&, Response& res) {
+        if (!window.enabled()) { res.status = 400; return; }
+        res.set_content(windowJson().dump(), "application/json");
+    });
+
+    // Everything the dashboard shows, from one snapshot and one history entry.
+    // Modes are capped like /calculate/mode, from the same index.
+    if constexpr (Dataset::exact) svr.Get("/calculate/summary", [&](const Request&, Response& res) {
+        Summary s;
+        json mode;
+        {
+            ReadLock lock(dataMutex);
+            s = Calculator::describe(dataset.getSorted());
+            const ModeIndex& idx = dataset.getModeIndex();
+            mode = {{"modes", idx.getModes()}, {"mode_count", idx.modeCount()}, {"mode_frequency", idx.frequency()}};
+        }
+        history.addRecord(Operation::Summary, s.mean);
+        json body = {
+            {"count", s.count}, {"mean", s.mean},
+            {"variance", s.variance}, {"sample_variance", s.sampleVariance},
+            {"sd", s.stdDev}, {"sample_sd", s.sampleStdDev},
+            {"min", s.min}, {"max", s.max},
+            {"q1", s.q1}, {"median", s.median}, {"q3", s.q3}, {"iqr", s.iqr},
+            {"skewness", s.skewness}, {"kurtosis", s.kurtosis}
+        };
+        body.update(mode);
+        res.set_content(body.dump(), "application/json");
+    });
+
+    // --- SKETCH MODE ---
+    if constexpr (!Dataset::exact) {
+        // Endpoints that need every point answer 501 instead of guessing
+        for (const char* path : {"/dataset", "/calculate/summary"})
+            svr.Get(path, [](const Request&, Response& res) {
+                res.status = 501;
+                res.set_content("not available in sketch mode", "text/plain");
+            });
+        svr.Get("/sketch", [&](const Request&, Response& res) {
+            ReadLock lock(dataMutex);
+            const KllSketch& s = dataset.getSketch();
+            res.set_content(json({
+                {"count", s.count()}, {"k", s.getK()}, {"retained", s.retainedItems()},
+                {"levels", s.levelCount()}, {"bytes", s.bytes()}, {"rank_error", s.rankError()},
+                {"heavy_hitters", dataset.getHeavyHitters().getCapacity()},
+                {"distinct_bytes", dataset.getDistinct().bytes()}
+            }).dump(), "application/json");
+        });
+    }
+
     // --- PROBABILITY (nCr, nPr, Binomial) ---
+    // "result" is a double (null once it exceeds DBL_MAX) and "log10" is
+    // always finite for non-zero counts. {"exact": true} adds the exact
+    // integer as a decimal string, up to Combinatorics::maxExactDigits.
+    // Pure functions of their arguments, so answers (including the encoded
+    // body and any error status) are memoized; history is still recorded
+    auto memoized = [&](Response& res, const ResultCache::Key& key, auto compute) {
+        auto entry = cache.get(key);
+        if (!entry) entry = cache.put(key, compute());
+        if (entry->status != 200) { res.status = entry->status; return; }
+        history.addRecord(key.op, entry->result);
+        res.set_content(entry->body, "application/json");
+    };
     svr.Post("/calculate/ncr", [&](const Request& req, Response& res) {
         auto j = json::parse(req.body);
-        double v = (double)Calculator::nCr(j["n"], j["r"]);
-        history.addRecord("nCr", v);
-        res.set_content(json({{"result", v}}).dump(), "application/json");
+        int64_t n = j["n"], r = j["r"];
+        bool exact = j.value("exact", false);
+        memoized(res, {Operation::NCr, n, r, 0, exact}, [&]() -> ResultCache::Entry {
+            double v = Calculator::nCr(n, r);
+            json body = {{"result", v}, {"log10", Combinatorics::logChoose(n, r) / std::log(10.0)}};
+            if (exact) {
+                std::string e = Combinatorics::chooseExact(n, r);
+                if (e.empty()) return {v, 400, ""};
+                body["exact"] = e;
+            }
+            return {v, 200, body.dump()};
+        });
     });
     svr.Post("/calculate/npr", [&](const Request& req, Response& res) {
         auto j = json::parse(req.body);
-        double v = (double)Calculator::nPr(j["n"], j["r"]);
-        history.addRecord("nPr", v);
-        res.set_content(json({{"result", v}}).dump(), "application/json");
+        int64_t n = j["n"], r = j["r"];
+        bool exact = j.value("exact", false);
+        memoized(res, {Operation::NPr, n, r, 0, exact}, [&]() -> ResultCache::Entry {
+            double v = Calculator::nPr(n, r);
+            json body = {{"result", v}, {"log10", Combinatorics::logPermute(n, r) / std::log(10.0)}};
+            if (exact) {
+                std::string e = Combinatorics::permuteExact(n, r);
+                if (e.empty()) return {v, 400, ""};
+                body["exact"] = e;
+            }
+            return {v, 200, body.dump()};
+        });
     });
     svr.Post("/calculate/binomial", [&](const Request& req, Response& res) {
         auto j = json::parse(req.body);
-        double v = Calculator::binomialProb(j["n"], j["k"], j["p"]);
-        history.addRecord("Binomial", v);
-        res.set_content(json({{"result", v}}).dump(), "application/json");
+        int64_t n = j["n"], k = j["k"];
+        double p = j["p"];
+        memoized(res, {Operation::Binomial, n, k, p, false}, [&]() -> ResultCache::Entry {
+            double v = Calculator::binomialProb(n, k, p);
+            return {v, 200, json({{"result", v}}).dump()};
+        });
+    });
+    svr.Get("/cache/status", [&](const Request&, Response& res) {
+        res.set_content(cache.status().dump(), "application/json");
     });
 
     // --- TWO EVENT SOLVER (MANUAL BUTTON LOGIC) ---
@@ -115,26 +382,167 @@ int main() {
 
             if (pa == -1 || pb == -1) { res.status = 400; return; }
 
-            double result = 0; std::string name = "";
-            if (op == "pa_not") { result = 1.0 - pa; name = "P(A')"; }
-            else if (op == "pb_not") { result = 1.0 - pb; name = "P(B')"; }
-            else if (op == "inter") { result = pa * pb; name = "P(AnB)"; }
-            else if (op == "union") { result = pa + pb - (pa * pb); name = "P(AuB)"; }
-            else if (op == "xor") { result = (pa + pb - (pa * pb)) - (pa * pb); name = "P(AxB)"; }
-            else if (op == "neither") { result = 1.0 - (pa + pb - (pa * pb)); name = "P((AuB)')"; }
+            double result = 0; Operation name = Operation::None;
+            if (op == "pa_not") { result = 1.0 - pa; name = Operation::NotA; }
+            else if (op == "pb_not") { result = 1.0 - pb; name = Operation::NotB; }
+            else if (op == "inter") { result = pa * pb; name = Operation::AAndB; }
+            else if (op == "union") { result = pa + pb - (pa * pb); name = Operation::AOrB; }
+            else if (op == "xor") { result = (pa + pb - (pa * pb)) - (pa * pb); name = Operation::AXorB; }
+            else if (op == "neither") { result = 1.0 - (pa + pb - (pa * pb)); name = Operation::Neither; }
 
             history.addRecord(name, result);
             res.set_content(json({{"result", result}}).dump(), "application/json");
         } catch (...) { res.status = 400; }
     });
 
-    svr.Get("/history", [&](const Request&, Response& res) {
-        res.set_content(history.getHistoryAsJson().dump(), "application/json");
+    // Without parameters the whole history as an array. ?offset=&limit= pages
+    // from the oldest entry; ?since=<seq> returns only what was appended after
+    // a client's last "next" (see HistoryManager::getSince)
+    svr.Get("/history", [&](const Request& req, Response& res) {
+        try {
+            size_t limit = req.has_param("limit") ? std::stoull(req.get_param_value("limit")) : 1000;
+            if (limit == 0) { res.status = 400; return; }
+            json body;
+            if (req.has_param("since")) body = history.getSince(std::stoull(req.get_param_value("since")), limit);
+            else if (req.has_param("offset") || req.has_param("limit"))
+                body = history.getPage(req.has_param("offset") ? std::stoull(req.get_param_value("offset")) : 0, limit);
+            else body = history.getHistoryAsJson();
+            res.set_content(body.dump(), "application/json");
+        } catch (...) { res.status = 400; }
     });
     svr.Post("/undo", [&](const Request&, Response& res) { history.undo(); res.status = 200; });
     svr.Post("/redo", [&](const Request&, Response& res) { history.redo(); res.status = 200; });
 
-    std::cout << "SERVER READY: Event Solver Active" << std::endl;
-    svr.listen("0.0.0.0", 8080);
+    svr.Get("/history/status", [&](const Request&, Response& res) {
+        res.set_content(history.getWriterStatus().dump(), "application/json");
+    });
+
+    // --- LIVE STREAM ---
+    // Server-sent events: "history" for every append/undo/redo, "stats" when
+    // the dataset changes, "reset" when a slow client's backlog was dropped.
+    // Each viewer holds one worker thread, so the pool is grown by the
+    // client limit; viewers past it get 503.
+    svr.new_task_queue = [streamClients] { return new ThreadPool(CPPHTTPLIB_THREAD_POOL_COUNT + streamClients); };
+    history.setListener([&](const json& change) { hub.publish("history", change); },
+                        [&] { return hub.clients() > 0; });
+
+    // Statistics are computed once per change for all viewers, at most every
+    // 250ms and only while someone is connected. The same loop notices a stop
+    // signal and closes the hub, since the handler itself can't safely
+    // notify; that releases the streams so listen() can join its pool.
+    std::mutex publisherMutex;
+    std::condition_variable publisherWake;
+    bool publisherStopping = false;
+    std::atomic<bool> newViewer{false};
+    std::thread statsPublisher([&] {
+        unsigned long long publishedVersion = ~0ULL;
+        json stats, windowStats;
+        std::unique_lock<std::mutex> lock(publisherMutex);
+        while (!publisherWake.wait_for(lock, std::chrono::milliseconds(250), [&] { return publisherStopping; })) {
+            if (stopRequested) hub.close();
+            if (hub.clients() == 0) continue;
+            bool changed = newViewer.exchange(false); // a new viewer needs the current stats
+            {
+                ReadLock dataLock(dataMutex);
+                if (dataset.getVersion() != publishedVersion) {
+                    publishedVersion = dataset.getVersion();
+                    const RunningStats& rs = dataset.getStats();
+                    stats = {{"count", rs.n}, {"mean", rs.getMean()}, {"sd", rs.stdDev()},
+                             {"min", rs.min}, {"max", rs.max}, {"median", dataset.median()}};
+                    changed = true;
+                }
+            }
+            // Points leave a time window without any ingest, so its
+            // snapshot is compared on every tick
+            if (window.enabled()) {
+                json w = windowJson();
+                if (w != windowStats) { windowStats = std::move(w); changed = true; }
+                stats["window"] = windowStats;
+            }
+            if (changed) hub.publish("stats", stats);
+        }
+    });
+
+    svr.Get("/stream", [&](const Request&, Response& res) {
+        auto sub = hub.subscribe();
+        if (!sub) { res.status = 503; return; }
+        newViewer = true;
+        res.set_header("Cache-Control", "no-cache");
+        res.set_chunked_content_provider("text/event-stream",
+            [&, sub](size_t, DataSink& sink) {
+                // An idle stream gets a comment line every 15s to detect
+                // dead peers; next() returns at once when the hub closes
+                for (int idle = 0; !stopRequested;) {
+                    StreamHub::Message msg = hub.next(*sub, std::chrono::milliseconds(1000));
+                    if (msg) return sink.write(msg->data(), msg->size());
+                    if (++idle == 15) return sink.write(": ping\n\n", 8);
+                }
+                return false;
+            },
+            [&, sub](bool) { hub.unsubscribe(sub); });
+    });
+    svr.Get("/stream/status", [&](const Request&, Response& res) {
+        res.set_content(hub.status().dump(), "application/json");
+    });
+
+    activeServer = &svr;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+
+    if (svr.bind_to_port("0.0.0.0", 8080) && !signalled) {
+        std::cout << "SERVER READY: Event Solver Active" << std::endl;
+        svr.listen_after_bind();
+    }
+    activeServer = nullptr;
+    history.setListener(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(publisherMutex);
+        publisherStopping = true;
+    }
+    publisherWake.notify_one();
+    statsPublisher.join();
     return 0;
-}
\ No newline at end of file
+}
+
+// --flat                     keep the dataset in a sorted vector instead of the tree
+// --parallel-threshold=<n>   split /calculate/summary across cores from n points up
+// --threads=<n>              worker threads for that split
+// --sketch[=<eps>]           bounded memory: keep a quantile sketch with rank
+//                            error eps (default 0.01) instead of every point
+// --window-count=<n>         sliding window over the last n points
+// --window-seconds=<t>       sliding window over the last t seconds
+// --history=<n>              history entries kept for undo and auditing (default 20)
+// --stream-clients=<n>       concurrent /stream viewers (default 64)
+// --cache=<n>                memoized nCr/nPr/binomial answers (default 4096, 0 = off)
+int main(int argc, char* argv[]) {
+    bool flat = false, sketch = false;
+    double eps = 0.01;
+    size_t windowCount = 0;
+    double windowSeconds = 0;
+    size_t historyDepth = 20;
+    size_t streamClients = 64;
+    size_t cacheSize = 4096;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--flat") flat = true;
+        else if (arg == "--sketch") sketch = true;
+        else if (arg.rfind("--sketch=", 0) == 0) { sketch = true; eps = std::stod(arg.substr(9)); }
+        else if (arg.rfind("--parallel-threshold=", 0) == 0) Parallel::setThreshold(std::stoull(arg.substr(21)));
+        else if (arg.rfind("--threads=", 0) == 0) Parallel::setThreads(std::stoul(arg.substr(10)));
+        else if (arg.rfind("--window-count=", 0) == 0) windowCount = std::stoull(arg.substr(15));
+        else if (arg.rfind("--window-seconds=", 0) == 0) windowSeconds = std::stod(arg.substr(17));
+        else if (arg.rfind("--history=", 0) == 0) historyDepth = std::stoull(arg.substr(10));
+        else if (arg.rfind("--stream-clients=", 0) == 0) streamClients = std::stoull(arg.substr(17));
+        else if (arg.rfind("--cache=", 0) == 0) cacheSize = std::stoull(arg.substr(8));
+    }
+    if (!(eps > 0 && eps < 1)) { // also rejects nan
+        std::cerr << "--sketch: eps must be between 0 and 1 exclusive\n";
+        return 1;
+    }
+    Combinatorics::logFactorial(0); // build the factorial table before serving
+    SlidingWindow window(windowCount, std::chrono::duration_cast<SlidingWindow::Clock::duration>(
+        std::chrono::duration<double>(windowSeconds)));
+    if (sketch) return run<SketchDataset>(window, historyDepth, streamClients, cacheSize, eps);
+    return flat ? run<FlatDataset>(window, historyDepth, streamClients, cacheSize)
+                : run<BST>(window, historyDepth, streamClients, cacheSize);
+}